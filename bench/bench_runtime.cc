@@ -0,0 +1,291 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               bench_runtime.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "alloc_counter.h"
+#include "sanitize_rt.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Benchmarks of the sanitizer runtime hooks, driving
+ * checkpoint::sanitizer::Sanitizer directly as the generated serialize
+ * overloads do. Every benchmark reports the time per hook invocation and the
+ * heap bytes allocated per object, so runtime changes can be compared before using them on real
+ * checkpoints.
+ */
+
+namespace checkpoint { namespace sanitizer {
+
+std::unique_ptr<Runtime> rt_;
+
+}} /* end namespace checkpoint::sanitizer */
+
+using checkpoint::sanitizer::Sanitizer;
+using checkpoint::sanitizer::StaticName;
+
+namespace {
+
+/**
+ * \struct ObjectGraph
+ *
+ * \brief A synthetic tree of objects: every object has \c members 8-byte
+ * members and \c width children, down to \c depth levels. Each member is left
+ * unserialized with probability \c miss_percent / 100, fixed at construction.
+ */
+struct ObjectGraph {
+
+  ObjectGraph(int in_width, int in_depth, int in_members, int miss_percent)
+    : width(in_width),
+      depth(in_depth),
+      members(in_members)
+  {
+    int level_objects = 1;
+    for (int d = 0; d < depth; d++) {
+      objects += level_objects;
+      level_objects *= width;
+    }
+
+    for (int d = 0; d < depth; d++) {
+      auto const type = "Level" + std::to_string(d);
+      type_strs.push_back(type);
+      for (int m = 0; m < members; m++) {
+        member_strs.push_back(type + "::m" + std::to_string(m));
+      }
+    }
+    for (auto&& t : type_strs) {
+      types.emplace_back(t.c_str());
+    }
+    for (auto&& m : member_strs) {
+      names.emplace_back(m.c_str());
+    }
+
+    storage.resize(static_cast<std::size_t>(objects) * members);
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{0, 99};
+    missed.resize(storage.size());
+    for (std::size_t i = 0; i < missed.size(); i++) {
+      missed[i] = dist(gen) < miss_percent;
+    }
+  }
+
+  /**
+   * \brief Serialize the graph through the sanitizer hooks
+   *
+   * \param[in] s the sanitizer
+   *
+   * \return the number of hooks invoked
+   */
+  uint64_t serialize(Sanitizer& s) {
+    next_ = 0;
+    return visit(s, 0);
+  }
+
+  int width = 0;
+  int depth = 0;
+  int members = 0;
+  int objects = 0;
+
+private:
+  uint64_t visit(Sanitizer& s, int level) {
+    auto const obj = static_cast<std::size_t>(next_++) * members;
+    auto const& tinfo = types[level];
+    uint64_t hooks = 2;
+    s.push(tinfo);
+    for (int m = 0; m < members; m++) {
+      auto addr = &storage[obj + m];
+      auto const& name = names[level * members + m];
+      s.checkMember(addr, name, int_name);
+      if (not missed[obj + m]) {
+        s.isSerialized(addr, 1, int_name);
+        hooks++;
+      }
+      hooks++;
+    }
+    if (level + 1 < depth) {
+      for (int c = 0; c < width; c++) {
+        hooks += visit(s, level + 1);
+      }
+    }
+    s.pop(tinfo);
+    return hooks;
+  }
+
+private:
+  std::vector<std::string> type_strs;
+  std::vector<std::string> member_strs;
+  std::vector<StaticName> types;
+  std::vector<StaticName> names;
+  StaticName const int_name{"long"};
+  std::vector<uint64_t> storage;
+  std::vector<bool> missed;
+  int next_ = 0;
+};
+
+/**
+ * \brief Get the runtime shared by all benchmarks. It lives until exit, so
+ * its summary is written once, after the results.
+ */
+Sanitizer& runtime() {
+  static Sanitizer s;
+  return s;
+}
+
+void setCounters(
+  benchmark::State& state, uint64_t hooks, uint64_t objects, uint64_t bytes
+) {
+  using benchmark::Counter;
+  state.counters["time/hook"] = Counter(
+    static_cast<double>(hooks), Counter::kIsRate | Counter::kInvert
+  );
+  state.counters["bytes/object"] = Counter(
+    objects == 0 ? 0.0 : static_cast<double>(bytes) / objects
+  );
+  state.SetItemsProcessed(static_cast<int64_t>(hooks));
+}
+
+/*
+ * Args: width, depth, members per object, miss rate in percent. The first
+ * iterations allocate the per-thread frames and intern the names, which the
+ * allocation counter averages over all iterations.
+ */
+void BM_ObjectGraph(benchmark::State& state) {
+  ObjectGraph graph{
+    static_cast<int>(state.range(0)), static_cast<int>(state.range(1)),
+    static_cast<int>(state.range(2)), static_cast<int>(state.range(3))
+  };
+  auto& s = runtime();
+  uint64_t hooks = 0, objects = 0;
+  auto const bytes_before = allocatedBytes();
+  for (auto _ : state) {
+    hooks += graph.serialize(s);
+    objects += graph.objects;
+  }
+  setCounters(state, hooks, objects, allocatedBytes() - bytes_before);
+}
+
+BENCHMARK(BM_ObjectGraph)
+  ->ArgNames({"width", "depth", "members", "miss%"})
+  ->Args({1, 1, 8, 0})
+  ->Args({1, 1, 64, 0})
+  ->Args({4, 4, 8, 0})
+  ->Args({4, 4, 8, 10})
+  ->Args({8, 4, 16, 0})
+  ->Args({8, 4, 16, 50})
+  ->Args({2, 12, 4, 0})
+  ->Args({2, 12, 4, 100});
+
+/*
+ * push and pop of objects without members: the frame cost alone
+ */
+void BM_PushPop(benchmark::State& state) {
+  auto& s = runtime();
+  StaticName const tinfo{"Empty"};
+  uint64_t objects = 0;
+  auto const bytes_before = allocatedBytes();
+  for (auto _ : state) {
+    s.push(tinfo);
+    s.pop(tinfo);
+    objects++;
+  }
+  setCounters(state, objects * 2, objects, allocatedBytes() - bytes_before);
+}
+
+BENCHMARK(BM_PushPop);
+
+/*
+ * checkMember alone, without isSerialized: every member of the object is
+ * reported missing, so validation at pop takes its slowest path. The time
+ * per hook includes the object's push and pop amortized over its members.
+ */
+void BM_CheckMember(benchmark::State& state) {
+  ObjectGraph graph{1, 1, static_cast<int>(state.range(0)), 100};
+  auto& s = runtime();
+  uint64_t hooks = 0, objects = 0;
+  auto const bytes_before = allocatedBytes();
+  for (auto _ : state) {
+    hooks += graph.serialize(s) - 2;
+    objects++;
+  }
+  setCounters(state, hooks, objects, allocatedBytes() - bytes_before);
+}
+
+BENCHMARK(BM_CheckMember)->ArgName("members")->Arg(1)->Arg(8)->Arg(64);
+
+/*
+ * checkMember paired with isSerialized on every member: the common case of a
+ * correct serializer. Counts both hooks.
+ */
+void BM_IsSerialized(benchmark::State& state) {
+  ObjectGraph graph{1, 1, static_cast<int>(state.range(0)), 0};
+  auto& s = runtime();
+  uint64_t hooks = 0, objects = 0;
+  auto const bytes_before = allocatedBytes();
+  for (auto _ : state) {
+    hooks += graph.serialize(s) - 2;
+    objects++;
+  }
+  setCounters(state, hooks, objects, allocatedBytes() - bytes_before);
+}
+
+BENCHMARK(BM_IsSerialized)->ArgName("members")->Arg(1)->Arg(8)->Arg(64);
+
+} /* end anon namespace */
+
+int main(int argc, char** argv) {
+  // keep the summaries of the benchmarked runtimes out of the results
+  checkpoint::sanitizer::output_as_file = true;
+  checkpoint::sanitizer::output_colorize = false;
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+#
+# Generate a synthetic code base and its compile_commands.json for measuring
+# the throughput of the sanitizer tool. Each translation unit defines classes
+# of four kinds, mirroring the patterns in tests/:
+#
+#   plain     non-template classes with a serialize template
+#   template  class templates instantiated with several argument types
+#   nested    member classes of class templates (tests/test-inner-class.cc)
+#   enable_if classes whose serialize is constrained with enable_if
+#             (tests/test-enable-if.cc), which the tool skips
+#
+
+import argparse
+import json
+import os
+
+MEMBER_TYPES = [
+    "int", "double", "long", "float", "std::vector<int>", "std::string",
+    "std::map<int, double>", "std::array<char, 16>",
+]
+
+COMMON_HEADER = """\
+#if !defined INCLUDED_SYNTHETIC_COMMON_H
+#define INCLUDED_SYNTHETIC_COMMON_H
+
+#include <array>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace synth {{
+
+struct Footprinter {{}};
+
+{templates}
+}} /* end namespace synth */
+
+#endif /*INCLUDED_SYNTHETIC_COMMON_H*/
+"""
+
+
+def members(count, offset, index_type=None):
+    types = [
+        index_type if index_type and i == 0 else
+        MEMBER_TYPES[(offset + i) % len(MEMBER_TYPES)]
+        for i in range(count)
+    ]
+    serialize = "".join("    s | m{}_;\n".format(i) for i in range(count))
+    fields = "".join(
+        "  {} m{}_;\n".format(t, i) for i, t in enumerate(types)
+    )
+    return serialize, fields
+
+
+def plain(name, count, offset):
+    serialize, fields = members(count, offset)
+    return (
+        "struct {name} {{\n"
+        "  template <typename SerializerT>\n"
+        "  void serialize(SerializerT& s) {{\n{serialize}  }}\n\n{fields}}};\n"
+    ).format(name=name, serialize=serialize, fields=fields)
+
+
+def template(name, count, offset):
+    serialize, fields = members(count, offset, "T")
+    return (
+        "template <typename T>\n"
+        "struct {name} {{\n"
+        "  template <typename SerializerT>\n"
+        "  void serialize(SerializerT& s) {{\n{serialize}  }}\n\n{fields}}};\n"
+        "{name}<int> {lower}_int;\n"
+        "{name}<double> {lower}_double;\n"
+        "{name}<std::string> {lower}_string;\n"
+    ).format(name=name, lower=name.lower(), serialize=serialize, fields=fields)
+
+
+def nested(name, count, offset):
+    serialize, fields = members(count, offset, "IndexT")
+    inner = "".join(
+        ("  " + l if l else l) + "\n"
+        for l in plain("Element", count, offset + 1).splitlines()
+    )
+    return (
+        "template <typename IndexT>\n"
+        "struct {name} {{\n{inner}\n"
+        "  template <typename SerializerT>\n"
+        "  void serialize(SerializerT& s) {{\n    s | elm_;\n{serialize}  }}\n\n"
+        "  Element elm_;\n{fields}}};\n"
+        "{name}<int> {lower}_int;\n"
+        "{name}<long> {lower}_long;\n"
+    ).format(
+        name=name, lower=name.lower(), inner=inner, serialize=serialize,
+        fields=fields
+    )
+
+
+def enable_if(name, count, offset):
+    serialize, fields = members(count, offset)
+    return (
+        "struct {name} {{\n"
+        "  template <\n"
+        "    typename SerializerT,\n"
+        "    typename enabled_ = std::enable_if_t<\n"
+        "      std::is_same<SerializerT, Footprinter>::value\n"
+        "    >\n"
+        "  >\n"
+        "  void serialize(SerializerT& s) {{\n{serialize}  }}\n\n{fields}}};\n"
+    ).format(name=name, serialize=serialize, fields=fields)
+
+
+KINDS = [plain, template, nested, enable_if]
+
+
+def generate(out, tus, classes, count, shared, compiler):
+    include = os.path.join(out, "include")
+    src = os.path.join(out, "src")
+    os.makedirs(include, exist_ok=True)
+    os.makedirs(src, exist_ok=True)
+
+    # classes in the common header are seen by every translation unit
+    templates = "".join(
+        KINDS[k % len(KINDS)]("Shared{}".format(k), count, k) + "\n"
+        for k in range(shared)
+    )
+    with open(os.path.join(include, "synthetic_common.h"), "w") as f:
+        f.write(COMMON_HEADER.format(templates=templates))
+
+    commands = []
+    for t in range(tus):
+        path = os.path.join(src, "tu_{}.cc".format(t))
+        with open(path, "w") as f:
+            f.write('#include "synthetic_common.h"\n\nnamespace synth {\n\n')
+            for c in range(classes):
+                kind = KINDS[c % len(KINDS)]
+                f.write(kind("Class{}_{}".format(t, c), count, t + c) + "\n")
+            f.write("} /* end namespace synth */\n")
+        commands.append({
+            "directory": out,
+            "command": "{} -std=c++14 -I{} -c {} -o tu_{}.o".format(
+                compiler, include, path, t
+            ),
+            "file": path,
+        })
+
+    with open(os.path.join(out, "compile_commands.json"), "w") as f:
+        json.dump(commands, f, indent=2)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate a synthetic code base for the sanitizer tool"
+    )
+    parser.add_argument("out", help="directory of the generated code base")
+    parser.add_argument("--tus", type=int, default=8,
+                        help="number of translation units")
+    parser.add_argument("--classes", type=int, default=1000,
+                        help="classes per translation unit")
+    parser.add_argument("--members", type=int, default=6,
+                        help="members per class")
+    parser.add_argument("--shared", type=int, default=100,
+                        help="classes in the header shared by all units")
+    parser.add_argument("--compiler", default="clang++",
+                        help="compiler named in the compile commands")
+    args = parser.parse_args()
+
+    out = os.path.abspath(args.out)
+    generate(out, args.tus, args.classes, args.members, args.shared,
+             args.compiler)
+    print("Generated {} translation units of {} classes in {}".format(
+        args.tus, args.classes, out
+    ))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+# Measure the throughput of the sanitizer tool over a compilation database:
+# a synthetic one from gen_synthetic.py or that of a real code base. The tool
+# is run with -stats-json, and the time of each translation unit is broken
+# down into the phases it reports (parse, match, walk, type-name, output).
+# Records/s counts the records matched; MB/s the generated code.
+#
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+PHASES = ["parse", "match", "walk", "type-name", "output"]
+
+
+def run_tool(args, stats_path):
+    cmd = [
+        args.sanitizer, "-p", args.build_dir, "-j", str(args.jobs),
+        "-o", os.devnull, "-stats-json", stats_path,
+    ] + args.tool_args + args.files
+    start = time.monotonic()
+    proc = subprocess.run(
+        cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+        universal_newlines=True
+    )
+    wall = time.monotonic() - start
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stderr)
+        sys.exit("sanitizer failed with exit code {}".format(proc.returncode))
+    with open(stats_path) as f:
+        return wall, json.load(f)
+
+
+def rate(amount, ns):
+    return amount / (ns * 1e-9) if ns > 0 else 0.0
+
+
+def row(name, stats):
+    total = stats["total_ns"]
+    phases = stats["phases_ns"]
+    other = max(0, total - sum(phases.values()))
+    percents = [
+        100.0 * phases[p] / total if total > 0 else 0.0 for p in PHASES
+    ] + [100.0 * other / total if total > 0 else 0.0]
+    return "{:<40} {:>10.1f} {:>8} {:>10.2f} {:>11.0f} {:>8.2f} {}".format(
+        name[-40:], total * 1e-6, stats["records"], stats["bytes"] / 1e6,
+        rate(stats["records"], total), rate(stats["bytes"], total) / 1e6,
+        " ".join("{:>9.1f}".format(p) for p in percents)
+    )
+
+
+def report(wall, stats):
+    header = "{:<40} {:>10} {:>8} {:>10} {:>11} {:>8} {}".format(
+        "translation unit", "ms", "records", "MB", "records/s", "MB/s",
+        " ".join("{:>9}".format(p[:9]) for p in PHASES + ["other"])
+    )
+    print("Phase columns are percentages of the time of each unit.\n")
+    print(header)
+    print("-" * len(header))
+    for tu in stats["translation_units"]:
+        print(row(os.path.basename(tu["file"]), tu))
+    print("-" * len(header))
+    print(row("total (sum over translation units)", stats["totals"]))
+    totals = stats["totals"]
+    wall_ns = stats["wall_ns"]
+    print(
+        "\nwall {:.1f} ms with {} jobs ({:.1f} ms including startup): "
+        "{:.0f} records/s, {:.2f} MB/s of generated code".format(
+            wall_ns * 1e-6, stats["jobs"], wall * 1e3,
+            rate(totals["records"], wall_ns),
+            rate(totals["bytes"], wall_ns) / 1e6
+        )
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure the throughput of the sanitizer tool"
+    )
+    parser.add_argument("sanitizer", help="path to the sanitizer binary")
+    parser.add_argument("build_dir",
+                        help="directory of compile_commands.json")
+    parser.add_argument("files", nargs="*",
+                        help="translation units (default: the whole database)")
+    parser.add_argument("-j", "--jobs", type=int, default=1,
+                        help="translation units processed in parallel")
+    parser.add_argument("-r", "--repeat", type=int, default=3,
+                        help="runs, of which the fastest is reported")
+    parser.add_argument("--tool-args", default="",
+                        help="extra arguments for the tool, e.g. '-layout'")
+    parser.add_argument("--json", help="also write the fastest run's stats here")
+    args = parser.parse_args()
+    args.tool_args = args.tool_args.split()
+
+    best = None
+    with tempfile.TemporaryDirectory() as tmp:
+        for i in range(args.repeat):
+            wall, stats = run_tool(args, os.path.join(tmp, "stats.json"))
+            if best is None or stats["wall_ns"] < best[1]["wall_ns"]:
+                best = (wall, stats)
+
+    report(*best)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(best[1], f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,7 @@ set -ex
 sanitizer_install=${1}
 target_source_dir=${2}
 target_build_dir=${3}
+jobs=${4:-$(nproc)}
 
 compile_commands="${target_build_dir}/compile_commands.json"
 
@@ -17,7 +18,6 @@ else
 fi
 
 sanitizer="${sanitizer_install}/bin/sanitizer"
-parse_json="${sanitizer_install}/scripts/parse-json.pl"
 
 if test -f ${sanitizer}
 then
@@ -27,16 +27,10 @@ else
     exit 2;
 fi
 
-if test -f ${parse_json}
-then
-    echo "Found sanitizer parse json script: ${parse_json}"
-else
-    echo "Could not find parse json script: ${parse_json}"
-    exit 3;
-fi
-
-${parse_json} 1 ${sanitizer} ${compile_commands} \.\* 'examples'
-${parse_json} 1 ${sanitizer} ${compile_commands} \.\* 'tests/unit' 'main.cc'
+${sanitizer} -p "${target_build_dir}" -in-place -j "${jobs}" \
+    -file-match 'examples'
+${sanitizer} -p "${target_build_dir}" -in-place -j "${jobs}" \
+    -file-match 'tests/unit' -ignore 'main.cc'
 
 pushd "${target_build_dir}"
 
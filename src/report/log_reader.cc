@@ -0,0 +1,150 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                log_reader.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "log_reader.h"
+#include "event_log.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace checkpoint { namespace sanitizer {
+
+namespace {
+
+template <typename T>
+bool readField(std::string const& buf, std::size_t& pos, std::size_t end, T& out) {
+  if (pos + sizeof(T) > end) {
+    return false;
+  }
+  std::memcpy(&out, buf.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+} /* end anon namespace */
+
+bool isEventLog(std::string const& buf) {
+  return buf.size() >= sizeof(event_log_magic) and
+    std::memcmp(buf.data(), event_log_magic, sizeof(event_log_magic)) == 0;
+}
+
+bool readEventLog(
+  std::string const& buf, Report& report, bool& truncated, std::string& error
+) {
+  EventLogHeader header;
+  if (not isEventLog(buf) or buf.size() < sizeof(header)) {
+    error = "not a sanitizer event log";
+    return false;
+  }
+  std::memcpy(&header, buf.data(), sizeof(header));
+  if (header.version != event_log_version) {
+    error = "unsupported event log version " + std::to_string(header.version);
+    return false;
+  }
+  report = Report{};
+  report.pids.push_back(header.pid);
+
+  // log IDs to report indices
+  std::unordered_map<uint32_t, uint32_t> names;
+  std::unordered_map<uint32_t, uint32_t> nodes;
+  auto name = [&](uint32_t id) {
+    auto iter = names.find(id);
+    return iter == names.end() ? report.addString("") : iter->second;
+  };
+  auto node = [&](uint32_t id) {
+    auto iter = nodes.find(id);
+    return iter == nodes.end() ? report_root_node : iter->second;
+  };
+
+  truncated = false;
+  std::size_t pos = sizeof(header);
+  while (true) {
+    EventRecordHeader rec;
+    if (not readField(buf, pos, buf.size(), rec)) {
+      // a log closed normally is truncated right after its last record
+      truncated = pos != buf.size();
+      break;
+    }
+    auto const end = pos + rec.size;
+    if (static_cast<EventKind>(rec.kind) == EventKind::End or end > buf.size()) {
+      truncated = true;
+      break;
+    }
+
+    uint32_t ids[3] = {0, 0, 0};
+    uint64_t sizes[2] = {0, 0};
+    switch (static_cast<EventKind>(rec.kind)) {
+    case EventKind::Name:
+      if (readField(buf, pos, end, ids[0])) {
+        names[ids[0]] = report.addString(buf.substr(pos, end - pos));
+      }
+      break;
+    case EventKind::Node:
+      if (readField(buf, pos, end, ids)) {
+        nodes[ids[0]] = report.addNode(node(ids[1]), name(ids[2]));
+      }
+      break;
+    case EventKind::Missing:
+      if (readField(buf, pos, end, ids)) {
+        report.add(name(ids[0]), name(ids[1]), false, node(ids[2]), 1);
+      }
+      break;
+    case EventKind::Partial:
+      if (readField(buf, pos, end, ids) and readField(buf, pos, end, sizes)) {
+        report.add(
+          name(ids[0]), name(ids[1]), true, node(ids[2]), 1, sizes[0], sizes[1]
+        );
+      }
+      break;
+    default:
+      // unknown records from a newer writer are skipped
+      break;
+    }
+    pos = end;
+  }
+  report.setRank(0);
+  return true;
+}
+
+}} /* end namespace checkpoint::sanitizer */
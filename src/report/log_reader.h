@@ -0,0 +1,80 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 log_reader.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_REPORT_LOG_READER_H
+#define INCLUDED_SANITIZER_REPORT_LOG_READER_H
+
+#include "report.h"
+
+#include <string>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \brief Read an event log written with \c VT_SANITIZE_LOG and aggregate its
+ * events into a report, as the process would have at shutdown
+ *
+ * \param[in] buf the contents of the log
+ * \param[out] report the report
+ * \param[out] truncated whether the log ends without the process shutting
+ * down (e.g., it was killed)
+ * \param[out] error the error if the log could not be read
+ *
+ * \return whether the log was read
+ */
+bool readEventLog(
+  std::string const& buf, Report& report, bool& truncated, std::string& error
+);
+
+/**
+ * \brief Whether a buffer starts like an event log
+ *
+ * \param[in] buf the buffer
+ */
+bool isEventLog(std::string const& buf);
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_REPORT_LOG_READER_H*/
@@ -0,0 +1,408 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                             sanitizer_report.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "log_reader.h"
+#include "report.h"
+#include "summary.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace checkpoint::sanitizer;
+
+namespace {
+
+struct Options {
+  std::string format = "text";
+  std::string output = "";
+  std::string sort = "instances";
+  std::string kind = "";
+  std::string name = "";
+  std::string type = "";
+  uint64_t min_instances = 0;
+  std::size_t top = 0;
+  bool colorize = true;
+  std::vector<std::string> inputs;
+};
+
+void usage(char const* argv0) {
+  fmt::print(
+    stderr,
+    "usage: {} [options] <report or log>...\n\n"
+    "Merges sanitizer reports (VT_SANITIZE_REPORT=1) and event logs\n"
+    "(VT_SANITIZE_LOG=1) and renders the result.\n\n"
+    "  -format F          text (default), json or binary\n"
+    "  -o FILE            write to FILE instead of stdout\n"
+    "  -name R            only members whose name matches R\n"
+    "  -type R            only members whose type matches R\n"
+    "  -kind K            only missing or partial members\n"
+    "  -min-instances N   only members with at least N instances\n"
+    "  -sort S            instances (default), name, type or coverage\n"
+    "  -top N             only the first N members after sorting\n"
+    "  -no-color          disable colors in text output\n",
+    argv0
+  );
+}
+
+bool parseOptions(int argc, char** argv, Options& opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string const arg = argv[i];
+    auto value = [&](std::string& out) {
+      if (i + 1 >= argc) {
+        fmt::print(stderr, "{} requires a value\n", arg);
+        return false;
+      }
+      out = argv[++i];
+      return true;
+    };
+    std::string num;
+    if (arg == "-format") {
+      if (not value(opts.format)) return false;
+    } else if (arg == "-o") {
+      if (not value(opts.output)) return false;
+    } else if (arg == "-name") {
+      if (not value(opts.name)) return false;
+    } else if (arg == "-type") {
+      if (not value(opts.type)) return false;
+    } else if (arg == "-kind") {
+      if (not value(opts.kind)) return false;
+    } else if (arg == "-sort") {
+      if (not value(opts.sort)) return false;
+    } else if (arg == "-min-instances") {
+      if (not value(num)) return false;
+      opts.min_instances = std::strtoull(num.c_str(), nullptr, 10);
+    } else if (arg == "-top") {
+      if (not value(num)) return false;
+      opts.top = static_cast<std::size_t>(std::strtoull(num.c_str(), nullptr, 10));
+    } else if (arg == "-no-color") {
+      opts.colorize = false;
+    } else if (arg == "-h" or arg == "-help") {
+      return false;
+    } else {
+      opts.inputs.push_back(arg);
+    }
+  }
+
+  if (
+    opts.format != "text" and opts.format != "json" and opts.format != "binary"
+  ) {
+    fmt::print(stderr, "Unknown format {}\n", opts.format);
+    return false;
+  }
+  if (opts.kind != "" and opts.kind != "missing" and opts.kind != "partial") {
+    fmt::print(stderr, "Unknown kind {}\n", opts.kind);
+    return false;
+  }
+  if (
+    opts.sort != "instances" and opts.sort != "name" and
+    opts.sort != "type" and opts.sort != "coverage"
+  ) {
+    fmt::print(stderr, "Unknown sort {}\n", opts.sort);
+    return false;
+  }
+  return not opts.inputs.empty();
+}
+
+// Read a report or an event log into a report
+bool readInput(std::string const& path, Report& report, std::string& error) {
+  std::ifstream in{path, std::ios::binary};
+  if (not in) {
+    error = "cannot open " + path;
+    return false;
+  }
+  std::string const buf{
+    std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}
+  };
+
+  if (isEventLog(buf)) {
+    bool truncated = false;
+    if (not readEventLog(buf, report, truncated, error)) {
+      error = path + ": " + error;
+      return false;
+    }
+    if (truncated) {
+      fmt::print(stderr, "{}: process did not shut down; log read up to the last record\n", path);
+    }
+    return true;
+  }
+  if (not report.deserialize(buf, error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+// Keep the entries of a report selected by the filters
+Report filterReport(Report const& in, Options const& opts) {
+  std::regex const name_re{opts.name == "" ? ".*" : opts.name};
+  std::regex const type_re{opts.type == "" ? ".*" : opts.type};
+
+  Report out;
+  out.pids = in.pids;
+  out.frames_pushed = in.frames_pushed;
+  out.frames_reused = in.frames_reused;
+
+  // copy only the strings and nodes the selected entries reach
+  std::vector<uint32_t> node_map(in.nodes.size(), report_root_node);
+  std::function<uint32_t(uint32_t)> mapNode = [&](uint32_t node) {
+    if (node == report_root_node) {
+      return report_root_node;
+    }
+    if (node_map[node] == report_root_node) {
+      auto const& n = in.nodes[node];
+      auto const parent = mapNode(n.parent);
+      node_map[node] = out.addNode(parent, out.addString(in.strings[n.tinfo]));
+    }
+    return node_map[node];
+  };
+
+  for (auto&& e : in.entries) {
+    if (
+      (opts.kind != "" and e.partial != (opts.kind == "partial")) or
+      e.instances < opts.min_instances or
+      not std::regex_search(in.strings[e.name], name_re) or
+      not std::regex_search(demangleName(in.strings[e.tinfo].c_str()), type_re)
+    ) {
+      continue;
+    }
+    auto const name = out.addString(in.strings[e.name]);
+    auto const tinfo = out.addString(in.strings[e.tinfo]);
+    bool first = true;
+    uint32_t idx = 0;
+    for (auto&& st : e.stacks) {
+      idx = out.add(
+        name, tinfo, e.partial, mapNode(st.node), st.instances,
+        first ? e.bytes : 0, first ? e.total : 0
+      );
+      first = false;
+    }
+    if (not first) {
+      out.entries[idx].ranks = e.ranks;
+      out.entries[idx].first_rank = e.first_rank;
+      out.entries[idx].histogram = e.histogram;
+    }
+  }
+  return out;
+}
+
+void sortMembers(std::vector<SummaryMember>& members, std::string const& sort) {
+  std::stable_sort(members.begin(), members.end(), [&](
+    SummaryMember const& m1, SummaryMember const& m2
+  ) {
+    if (sort == "name") {
+      return m1.name < m2.name;
+    } else if (sort == "type") {
+      return m1.tinfo < m2.tinfo;
+    } else if (sort == "coverage") {
+      return m1.partial != m2.partial ? m2.partial : m1.coverage < m2.coverage;
+    }
+    return m1.instances > m2.instances;
+  });
+}
+
+std::string jsonString(std::string const& str) {
+  std::string out = "\"";
+  for (auto c : str) {
+    switch (c) {
+    case '"':  out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n";  break;
+    case '\t': out += "\\t";  break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out += fmt::format("\\u{:04x}", static_cast<int>(c));
+      } else {
+        out += c;
+      }
+    }
+  }
+  return out + "\"";
+}
+
+void renderJSON(
+  FILE* fd, Report const& report, std::vector<SummaryMember> const& members
+) {
+  fmt::memory_buffer buf;
+  fmt::format_to(buf, "{{\n  \"pids\": [");
+  for (std::size_t i = 0; i < report.pids.size(); i++) {
+    fmt::format_to(buf, "{}{}", i > 0 ? ", " : "", report.pids[i]);
+  }
+  fmt::format_to(
+    buf, "],\n  \"frames_pushed\": {},\n  \"frames_reused\": {},\n  \"members\": [",
+    report.frames_pushed, report.frames_reused
+  );
+  for (std::size_t i = 0; i < members.size(); i++) {
+    auto const& m = members[i];
+    fmt::format_to(
+      buf,
+      "{}\n    {{\n      \"name\": {},\n      \"type\": {},\n"
+      "      \"kind\": \"{}\",\n      \"instances\": {},\n",
+      i > 0 ? "," : "", jsonString(m.name),
+      jsonString(demangleName(m.tinfo.c_str())),
+      m.partial ? "partial" : "missing", m.instances
+    );
+    if (m.partial) {
+      fmt::format_to(buf, "      \"coverage\": {:.1f},\n", m.coverage);
+    }
+    fmt::format_to(
+      buf, "      \"ranks\": {},\n      \"first_rank\": {},\n"
+      "      \"rank_histogram\": [", m.ranks, m.first_rank
+    );
+    for (std::size_t j = 0; j < m.histogram.size(); j++) {
+      auto const& bin = m.histogram[j];
+      fmt::format_to(
+        buf, "{}{{ \"min\": {}, \"max\": {}, \"ranks\": {} }}",
+        j > 0 ? ", " : "", bin.min, bin.max, bin.ranks
+      );
+    }
+    fmt::format_to(buf, "],\n");
+    fmt::format_to(buf, "      \"stacks\": [");
+    for (std::size_t j = 0; j < m.stacks.size(); j++) {
+      auto const& st = m.stacks[j];
+      fmt::format_to(
+        buf, "{}\n        {{ \"instances\": {}, \"frames\": [",
+        j > 0 ? "," : "", st.instances
+      );
+      for (std::size_t k = 0; k < st.frames.size(); k++) {
+        fmt::format_to(
+          buf, "{}{}", k > 0 ? ", " : "",
+          jsonString(demangleName(st.frames[k].c_str()))
+        );
+      }
+      fmt::format_to(buf, "] }}");
+    }
+    fmt::format_to(buf, "\n      ]\n    }}");
+  }
+  fmt::format_to(buf, "\n  ]\n}}\n");
+  std::fwrite(buf.data(), 1, buf.size(), fd);
+}
+
+void renderText(
+  FILE* fd, Report const& report, std::vector<SummaryMember> const& members,
+  bool colorize
+) {
+  auto const pid = report.pids.size() == 1 ? static_cast<pid_t>(report.pids[0]) : 0;
+  SummaryPrinter out{fd, pid, colorize};
+  out.banner();
+  if (report.pids.size() > 1) {
+    out.line("---- merged from {} processes ----\n", report.pids.size());
+  }
+  out.line(
+    "---- frames pushed: {}, reused from pool: {} ----\n",
+    report.frames_pushed, report.frames_reused
+  );
+  for (auto&& member : members) {
+    out.member(member);
+  }
+}
+
+} /* end anon namespace */
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (not parseOptions(argc, argv, opts)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Report merged;
+  for (auto&& path : opts.inputs) {
+    Report report;
+    std::string error;
+    if (not readInput(path, report, error)) {
+      fmt::print(stderr, "{}\n", error);
+      return 1;
+    }
+    merged.merge(report);
+  }
+
+  Report report;
+  try {
+    report = filterReport(merged, opts);
+  } catch (std::regex_error const& e) {
+    fmt::print(stderr, "Invalid regex: {}\n", e.what());
+    return 1;
+  }
+
+  FILE* fd = stdout;
+  if (opts.output != "") {
+    fd = fopen(opts.output.c_str(), opts.format == "binary" ? "wb" : "w");
+    if (fd == nullptr) {
+      fmt::print(stderr, "Could not open {}\n", opts.output);
+      return 1;
+    }
+  }
+
+  if (opts.format == "binary") {
+    std::string buf;
+    report.serialize(buf);
+    std::fwrite(buf.data(), 1, buf.size(), fd);
+  } else {
+    auto members = report.toSummary();
+    sortMembers(members, opts.sort);
+    if (opts.top > 0 and members.size() > opts.top) {
+      members.resize(opts.top);
+    }
+    if (opts.format == "json") {
+      renderJSON(fd, report, members);
+    } else {
+      renderText(fd, report, members, opts.colorize and opts.output == "");
+    }
+  }
+
+  if (fd != stdout) {
+    fclose(fd);
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                              call_stack_trie.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_CALL_STACK_TRIE_H
+#define INCLUDED_SANITIZER_RUNTIME_CALL_STACK_TRIE_H
+
+#include "runtime_interface.h"
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <mutex>
+
+namespace checkpoint { namespace sanitizer {
+
+/// Identifier for a node in the \c CallStackTrie
+using StackNodeIDType = uint32_t;
+
+/// The parent of the outermost frames in the \c CallStackTrie
+static constexpr StackNodeIDType const root_stack_node =
+  static_cast<StackNodeIDType>(-1);
+
+/// A stack frame whose node in the \c CallStackTrie is not resolved yet
+static constexpr StackNodeIDType const unresolved_stack_node =
+  static_cast<StackNodeIDType>(-2);
+
+/// Number of independently locked shards in the concurrent tables
+static constexpr std::size_t const num_registry_shards = 16;
+
+/**
+ * \struct CallStackTrie
+ *
+ * \brief Shared prefix trie of call stacks. A node is a type frame under its
+ * parent node, so a node identifies the whole stack from the outermost frame
+ * down to it; stacks sharing a prefix share those nodes. Sharded by the
+ * (parent, type) key so threads extending different paths rarely contend.
+ */
+struct CallStackTrie {
+
+  /**
+   * \brief Get (or create) the node for a type frame under a parent node
+   *
+   * \param[in] parent the parent node or \c root_stack_node
+   * \param[in] tinfo the type of the frame
+   *
+   * \return the node
+   */
+  StackNodeIDType child(StackNodeIDType parent, NameIDType tinfo) {
+    auto const key = (static_cast<uint64_t>(parent) << 32) | tinfo;
+    auto const shard_idx = static_cast<std::size_t>(
+      (key * 0x9E3779B97F4A7C15ull >> 32) % num_registry_shards
+    );
+    auto& shard = shards_[shard_idx];
+    std::lock_guard<std::mutex> guard{shard.mutex};
+
+    auto iter = shard.children.find(key);
+    if (iter != shard.children.end()) {
+      return iter->second;
+    }
+
+    auto const local = shard.nodes.size();
+    auto const id = static_cast<StackNodeIDType>(
+      local * num_registry_shards + shard_idx
+    );
+    shard.nodes.push_back(Node{parent, tinfo});
+    shard.children.emplace(key, id);
+    return id;
+  }
+
+  /**
+   * \brief Walk a node up to the root to get the stack it identifies
+   *
+   * \param[in] node the node
+   *
+   * \return the type IDs of the frames, innermost first
+   */
+  std::vector<NameIDType> getStack(StackNodeIDType node) const {
+    std::vector<NameIDType> stack;
+    while (node != root_stack_node) {
+      auto const& shard = shards_[node % num_registry_shards];
+      std::lock_guard<std::mutex> guard{shard.mutex};
+      auto const& n = shard.nodes.at(node / num_registry_shards);
+      stack.push_back(n.tinfo);
+      node = n.parent;
+    }
+    return stack;
+  }
+
+  /**
+   * \brief Get the parent and type of a node
+   *
+   * \param[in] node the node
+   * \param[out] parent the parent node or \c root_stack_node
+   * \param[out] tinfo the type of the frame
+   */
+  void getNode(
+    StackNodeIDType node, StackNodeIDType& parent, NameIDType& tinfo
+  ) const {
+    auto const& shard = shards_[node % num_registry_shards];
+    std::lock_guard<std::mutex> guard{shard.mutex};
+    auto const& n = shard.nodes.at(node / num_registry_shards);
+    parent = n.parent;
+    tinfo = n.tinfo;
+  }
+
+private:
+  struct Node {
+    StackNodeIDType parent = root_stack_node;
+    NameIDType tinfo = no_name_id;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<Node> nodes;
+    /// (parent, type) to node
+    std::unordered_map<uint64_t, StackNodeIDType> children;
+  };
+
+  std::array<Shard, num_registry_shards> shards_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_CALL_STACK_TRIE_H*/
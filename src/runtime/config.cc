@@ -0,0 +1,162 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  config.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "config.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace checkpoint { namespace sanitizer {
+
+bool envFlagOn(char const* name) {
+  char* val = getenv(name);
+  if (val != nullptr) {
+    auto str = std::string{val};
+    return str == "1" or str == "ON" or str == "on" or str == "true" or str == "TRUE";
+  }
+  return false;
+}
+
+bool envFlagOff(char const* name) {
+  char* val = getenv(name);
+  if (val != nullptr) {
+    auto str = std::string{val};
+    return str == "0" or str == "OFF" or str == "off" or str == "false" or str == "FALSE";
+  }
+  return false;
+}
+
+uint64_t envUnsigned(char const* name, uint64_t default_value) {
+  char* val = getenv(name);
+  if (val != nullptr) {
+    char* end = nullptr;
+    auto ret = std::strtoull(val, &end, 10);
+    if (end != val and *end == '\0') {
+      return static_cast<uint64_t>(ret);
+    }
+  }
+  return default_value;
+}
+
+double envDouble(char const* name, double default_value) {
+  char* val = getenv(name);
+  if (val != nullptr) {
+    char* end = nullptr;
+    auto ret = std::strtod(val, &end);
+    if (end != val and *end == '\0') {
+      return ret;
+    }
+  }
+  return default_value;
+}
+
+/*static*/ SampleConfig SampleConfig::fromEnv() {
+  SampleConfig config;
+  config.every = envUnsigned("VT_SANITIZE_SAMPLE_EVERY", 1);
+  config.probability = envDouble("VT_SANITIZE_SAMPLE_PROBABILITY", 1.0);
+  config.budget = envUnsigned("VT_SANITIZE_SAMPLE_BUDGET", 0);
+  config.stop_after = envUnsigned("VT_SANITIZE_SAMPLE_STOP_AFTER", 0);
+  if (config.every == 0) {
+    config.every = 1;
+  }
+  return config;
+}
+
+/*static*/ CacheConfig CacheConfig::fromEnv() {
+  CacheConfig config;
+  config.after = envUnsigned("VT_SANITIZE_CACHE_AFTER", 0);
+  return config;
+}
+
+/*static*/ LogConfig LogConfig::fromEnv() {
+  LogConfig config;
+  config.enabled = envFlagOn("VT_SANITIZE_LOG");
+  return config;
+}
+
+/*static*/ ReportConfig ReportConfig::fromEnv() {
+  ReportConfig config;
+  config.binary = envFlagOn("VT_SANITIZE_REPORT");
+  config.reduce = not envFlagOff("VT_SANITIZE_REDUCE");
+  return config;
+}
+
+/*static*/ ProfileConfig ProfileConfig::fromEnv() {
+  ProfileConfig config;
+  config.enabled = envFlagOn("VT_SANITIZE_PROFILE");
+  config.signum = static_cast<int>(
+    envUnsigned("VT_SANITIZE_PROFILE_SIGNAL", SIGUSR1)
+  );
+  config.period = envUnsigned("VT_SANITIZE_PROFILE_PERIOD", 64);
+  return config;
+}
+
+/*static*/ ControlConfig ControlConfig::fromEnv() {
+  ControlConfig config;
+  config.enabled = not envFlagOff("VT_SANITIZE_ENABLED");
+  config.signum = static_cast<int>(envUnsigned("VT_SANITIZE_TOGGLE_SIGNAL", 0));
+
+  // a malformed entry is ignored rather than selecting unintended phases
+  char* val = getenv("VT_SANITIZE_PHASES");
+  char const* str = val;
+  while (str != nullptr and *str != '\0') {
+    char* end = nullptr;
+    auto const first = std::strtoull(str, &end, 10);
+    auto last = first;
+    if (end != str and *end == '-') {
+      str = end + 1;
+      last = std::strtoull(str, &end, 10);
+    }
+    if (end != str and (*end == ',' or *end == '\0') and first <= last) {
+      config.phases.emplace_back(first, last);
+    }
+    str = std::strchr(str, ',');
+    str = str != nullptr ? str + 1 : nullptr;
+  }
+  return config;
+}
+
+}} /* end namespace checkpoint::sanitizer */
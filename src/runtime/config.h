@@ -0,0 +1,269 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                   config.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_CONFIG_H
+#define INCLUDED_SANITIZER_RUNTIME_CONFIG_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \brief Check if an environment variable is set to an "on" value
+ *
+ * \param[in] name the environment variable
+ *
+ * \return whether it is set to 1, ON, on, true or TRUE
+ */
+bool envFlagOn(char const* name);
+
+/**
+ * \brief Check if an environment variable is set to an "off" value
+ *
+ * \param[in] name the environment variable
+ *
+ * \return whether it is set to 0, OFF, off, false or FALSE
+ */
+bool envFlagOff(char const* name);
+
+/**
+ * \brief Read an unsigned integer from an environment variable
+ *
+ * \param[in] name the environment variable
+ * \param[in] default_value the value if unset or malformed
+ *
+ * \return the value
+ */
+uint64_t envUnsigned(char const* name, uint64_t default_value);
+
+/**
+ * \brief Read a floating point value from an environment variable
+ *
+ * \param[in] name the environment variable
+ * \param[in] default_value the value if unset or malformed
+ *
+ * \return the value
+ */
+double envDouble(char const* name, double default_value);
+
+/**
+ * \struct SampleConfig
+ *
+ * \brief Controls which objects pushed on the sanitizer stack are checked.
+ * All the criteria apply per type; an object is checked only if every enabled
+ * criterion selects it. The objects nested in an object that is not checked
+ * are not checked either.
+ *
+ *  - \c VT_SANITIZE_SAMPLE_EVERY=N: check every Nth object of a type pushed
+ *    by each thread
+ *  - \c VT_SANITIZE_SAMPLE_PROBABILITY=P: check an object with probability P
+ *  - \c VT_SANITIZE_SAMPLE_BUDGET=B: check at most B objects of a type
+ *  - \c VT_SANITIZE_SAMPLE_STOP_AFTER=K: stop checking a type once K
+ *    consecutive objects of it were validated without missing members
+ */
+struct SampleConfig {
+
+  /**
+   * \brief Read the sampling configuration from the environment
+   *
+   * \return the configuration
+   */
+  static SampleConfig fromEnv();
+
+  /**
+   * \brief Whether any sampling criterion is enabled
+   */
+  bool enabled() const {
+    return every > 1 or probability < 1.0 or budget > 0 or stop_after > 0;
+  }
+
+  uint64_t every = 1;
+  double probability = 1.0;
+  uint64_t budget = 0;
+  uint64_t stop_after = 0;
+};
+
+/**
+ * \struct CacheConfig
+ *
+ * \brief Controls the per-type validation cache. With
+ * \c VT_SANITIZE_CACHE_AFTER=N, a type whose last N checked objects were
+ * clean with the same fingerprint of relative member offsets and bulk byte
+ * counts is proven: later
+ * objects of it only compute the fingerprint, and the type goes back to full
+ * checking as soon as a fingerprint differs; that object is checked in full
+ * from the hooks its frame kept. Disabled when 0 (the default).
+ */
+struct CacheConfig {
+
+  /**
+   * \brief Read the cache configuration from the environment
+   *
+   * \return the configuration
+   */
+  static CacheConfig fromEnv();
+
+  /**
+   * \brief Whether the validation cache is enabled
+   */
+  bool enabled() const { return after > 0; }
+
+  uint64_t after = 0;
+};
+
+/**
+ * \struct LogConfig
+ *
+ * \brief Controls the streaming event log. With \c VT_SANITIZE_LOG=1, every
+ * missing or partially serialized member instance is appended to
+ * \c <pid>.sanitize.log as it is found instead of being accumulated for the
+ * summary at shutdown; \c sanitizer-report renders the summary from the log.
+ */
+struct LogConfig {
+
+  /**
+   * \brief Read the event log configuration from the environment
+   *
+   * \return the configuration
+   */
+  static LogConfig fromEnv();
+
+  bool enabled = false;
+};
+
+/**
+ * \struct ReportConfig
+ *
+ * \brief Controls the format of the output at shutdown. With
+ * \c VT_SANITIZE_REPORT=1, a binary report is written to
+ * \c <pid>.sanitize.report in one write instead of the text summary;
+ * \c sanitizer-report merges and renders reports. In an MPI job, the
+ * reports of all ranks are reduced to rank 0 when \c MPI_Finalize is
+ * called, which writes the only output; \c VT_SANITIZE_REDUCE=0 keeps one
+ * output per rank.
+ */
+struct ReportConfig {
+
+  /**
+   * \brief Read the report configuration from the environment
+   *
+   * \return the configuration
+   */
+  static ReportConfig fromEnv();
+
+  bool binary = false;
+  bool reduce = true;
+};
+
+/**
+ * \struct ProfileConfig
+ *
+ * \brief Controls the self-profile of the runtime. The counters are always
+ * kept; with \c VT_SANITIZE_PROFILE=1 they are printed to stderr at shutdown
+ * and each time the process receives \c VT_SANITIZE_PROFILE_SIGNAL (\c
+ * SIGUSR1 by default, 0 for none). The time spent in hooks is measured on
+ * one call out of \c VT_SANITIZE_PROFILE_PERIOD (64 by default, 0 for never).
+ */
+struct ProfileConfig {
+
+  /**
+   * \brief Read the profile configuration from the environment
+   *
+   * \return the configuration
+   */
+  static ProfileConfig fromEnv();
+
+  bool enabled = false;
+  int signum = 0;
+  uint64_t period = 64;
+};
+
+/**
+ * \struct ControlConfig
+ *
+ * \brief Controls when sanitization is on, so the runtime can stay preloaded
+ * and be enabled surgically:
+ *
+ *  - \c VT_SANITIZE_ENABLED=0: start with sanitization off
+ *  - \c VT_SANITIZE_TOGGLE_SIGNAL=N: flip sanitization on or off each time
+ *    the process receives signal \c N; ignored with a warning when it is
+ *    also the profile signal of an enabled \c ProfileConfig
+ *  - \c VT_SANITIZE_PHASES=L: only sanitize the phases in the list \c L
+ *    of numbers and ranges (e.g., \c 3 or \c 1,4-6), counted by
+ *    \c checkpoint_sanitizer_begin_phase
+ */
+struct ControlConfig {
+
+  /**
+   * \brief Read the control configuration from the environment
+   *
+   * \return the configuration
+   */
+  static ControlConfig fromEnv();
+
+  /**
+   * \brief Whether a phase is in \c phases
+   *
+   * \param[in] phase the phase number
+   */
+  bool selects(uint64_t phase) const {
+    for (auto&& range : phases) {
+      if (phase >= range.first and phase <= range.second) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool enabled = true;
+  int signum = 0;
+  /// Inclusive ranges of the phases sanitized; all when empty
+  std::vector<std::pair<uint64_t, uint64_t>> phases;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_CONFIG_H*/
@@ -0,0 +1,128 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  control.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "control.h"
+#include "config.h"
+
+#include <fmt/format.h>
+
+#include <csignal>
+
+namespace checkpoint { namespace sanitizer {
+
+std::atomic<bool> sanitize_active{true};
+
+namespace {
+
+void onToggleSignal(int) {
+  toggleSanitizeActive();
+}
+
+/**
+ * \internal \struct Control
+ *
+ * \brief Applies the control configuration when the runtime is loaded, so
+ * the flag is set before the first serialization reads it
+ */
+struct Control {
+  Control()
+    : config(ControlConfig::fromEnv())
+  {
+    // with phases, nothing is sanitized until a selected phase begins
+    sanitize_active.store(
+      config.enabled and config.phases.empty(), std::memory_order_relaxed
+    );
+    // the profile handler is installed with the runtime and would replace
+    // this one, silently disabling the toggle
+    auto const profile = ProfileConfig::fromEnv();
+    if (
+      config.signum != 0 and profile.enabled and
+      profile.signum == config.signum
+    ) {
+      fmt::print(
+        stderr,
+        "Sanitizer: VT_SANITIZE_TOGGLE_SIGNAL={} is also the profile signal; "
+        "ignoring it (set VT_SANITIZE_PROFILE_SIGNAL to another signal)\n",
+        config.signum
+      );
+    } else if (config.signum != 0) {
+      struct sigaction action = {};
+      action.sa_handler = onToggleSignal;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      sigaction(config.signum, &action, nullptr);
+    }
+  }
+
+  ControlConfig const config;
+  std::atomic<uint64_t> phase{0};
+};
+
+Control control;
+
+} /* end anon namespace */
+
+void setSanitizeActive(bool active) {
+  sanitize_active.store(active, std::memory_order_relaxed);
+}
+
+void toggleSanitizeActive() {
+  static_assert(
+    ATOMIC_BOOL_LOCK_FREE == 2, "The toggle signal needs a lock-free flag"
+  );
+  sanitize_active.store(
+    not sanitize_active.load(std::memory_order_relaxed),
+    std::memory_order_relaxed
+  );
+}
+
+uint64_t beginSanitizePhase() {
+  auto const phase = control.phase.fetch_add(1) + 1;
+  if (not control.config.phases.empty()) {
+    setSanitizeActive(control.config.selects(phase));
+  }
+  return phase;
+}
+
+}} /* end namespace checkpoint::sanitizer */
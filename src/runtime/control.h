@@ -0,0 +1,92 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  control.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_CONTROL_H
+#define INCLUDED_SANITIZER_RUNTIME_CONTROL_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \brief Whether sanitization is on. Set from \c ControlConfig when the
+ * runtime is loaded, then by the toggle signal and the phase API. It is read
+ * with a relaxed load on every serialization, so a caller that keeps its
+ * address pays a single predictable branch while sanitization is off.
+ */
+extern std::atomic<bool> sanitize_active;
+
+/**
+ * \brief Whether sanitization is on
+ */
+inline bool sanitizeActive() {
+  return sanitize_active.load(std::memory_order_relaxed);
+}
+
+/**
+ * \brief Turn sanitization on or off. Serializations already in progress
+ * finish in the state they started in.
+ *
+ * \param[in] active whether sanitization is on
+ */
+void setSanitizeActive(bool active);
+
+/**
+ * \brief Flip sanitization on or off; async-signal-safe
+ */
+void toggleSanitizeActive();
+
+/**
+ * \brief Start the next phase (e.g., checkpoint) of the application,
+ * turning sanitization on if \c VT_SANITIZE_PHASES selects it and off
+ * otherwise; without \c VT_SANITIZE_PHASES, sanitization is left as is
+ *
+ * \return the number of the phase started, from 1
+ */
+uint64_t beginSanitizePhase();
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_CONTROL_H*/
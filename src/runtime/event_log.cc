@@ -0,0 +1,225 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 event_log.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "event_log.h"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstddef>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace checkpoint { namespace sanitizer {
+
+EventLog::EventLog(
+  std::string const& path, NameTable const& names, CallStackTrie const& stacks
+) : path_(path),
+    names_(names),
+    stacks_(stacks)
+{
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    perror("Error opening sanitizer event log: ");
+    return;
+  }
+
+  EventLogHeader header;
+  std::memcpy(header.magic, event_log_magic, sizeof(header.magic));
+  header.version = event_log_version;
+  header.pid = static_cast<uint32_t>(getpid());
+
+  std::lock_guard<std::mutex> guard{mutex_};
+  if (not reserve(sizeof(header))) {
+    return;
+  }
+  std::memcpy(window_ + (offset_ - window_offset_), &header, sizeof(header));
+  offset_ += sizeof(header);
+}
+
+EventLog::~EventLog() {
+  if (window_ != nullptr) {
+    munmap(window_, window_size);
+  }
+  if (fd_ >= 0) {
+    // drop the unused tail of the last window
+    if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+      perror("Error truncating sanitizer event log: ");
+    }
+    close(fd_);
+  }
+}
+
+bool EventLog::reserve(std::size_t len) {
+  if (fd_ < 0) {
+    return false;
+  }
+  if (window_ != nullptr and offset_ + len <= window_offset_ + window_size) {
+    return true;
+  }
+
+  // slide the window to the page that holds the end of the log
+  if (window_ != nullptr) {
+    munmap(window_, window_size);
+    window_ = nullptr;
+  }
+  auto const page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  window_offset_ = offset_ / page * page;
+  if (offset_ + len > window_offset_ + window_size) {
+    fmt::print(stderr, "Sanitizer event log record too large: {}\n", len);
+    return false;
+  }
+
+  auto const end = static_cast<off_t>(window_offset_ + window_size);
+  auto const mapped = ftruncate(fd_, end) != 0 ? MAP_FAILED : mmap(
+    nullptr, window_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+    static_cast<off_t>(window_offset_)
+  );
+  if (mapped == MAP_FAILED) {
+    perror("Error mapping sanitizer event log: ");
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  window_ = static_cast<char*>(mapped);
+  return true;
+}
+
+void EventLog::write(
+  EventKind kind, void const* a, std::size_t a_len, void const* b,
+  std::size_t b_len
+) {
+  EventRecordHeader header;
+  header.kind = static_cast<uint16_t>(kind);
+  header.reserved = 0;
+  header.size = static_cast<uint32_t>(a_len + b_len);
+
+  auto const len = sizeof(header) + a_len + b_len;
+  if (not reserve(len)) {
+    return;
+  }
+
+  // the kind is written last so a record cut short by a kill reads as the end
+  // of the log (the window is zero-filled); the fence keeps the compiler from
+  // moving the payload stores after it
+  auto out = window_ + (offset_ - window_offset_);
+  std::memcpy(out + sizeof(header), a, a_len);
+  if (b_len > 0) {
+    std::memcpy(out + sizeof(header) + a_len, b, b_len);
+  }
+  std::memcpy(
+    out + offsetof(EventRecordHeader, size), &header.size, sizeof(header.size)
+  );
+  std::atomic_signal_fence(std::memory_order_release);
+  std::memcpy(
+    out + offsetof(EventRecordHeader, kind), &header.kind, sizeof(header.kind)
+  );
+  offset_ += len;
+}
+
+void EventLog::defineName(NameIDType id) {
+  if (id < names_written_.size() and names_written_[id]) {
+    return;
+  }
+  if (id >= names_written_.size()) {
+    names_written_.resize(id + 1, false);
+  }
+  names_written_[id] = true;
+
+  auto const str = names_.getName(id);
+  write(EventKind::Name, &id, sizeof(id), str, std::strlen(str));
+}
+
+void EventLog::defineNode(StackNodeIDType node) {
+  // define the path from the outermost undefined ancestor down
+  std::vector<StackNodeIDType> path;
+  for (auto n = node; n != root_stack_node; ) {
+    if (n < nodes_written_.size() and nodes_written_[n]) {
+      break;
+    }
+    path.push_back(n);
+    NameIDType tinfo = no_name_id;
+    stacks_.getNode(n, n, tinfo);
+  }
+
+  for (auto iter = path.rbegin(); iter != path.rend(); ++iter) {
+    auto const n = *iter;
+    uint32_t record[3] = { n, 0, 0 };
+    stacks_.getNode(n, record[1], record[2]);
+    defineName(record[2]);
+    write(EventKind::Node, record, sizeof(record));
+    if (n >= nodes_written_.size()) {
+      nodes_written_.resize(n + 1, false);
+    }
+    nodes_written_[n] = true;
+  }
+}
+
+void EventLog::missing(
+  NameIDType name, NameIDType tinfo, StackNodeIDType node
+) {
+  std::lock_guard<std::mutex> guard{mutex_};
+  defineName(name);
+  defineName(tinfo);
+  defineNode(node);
+  uint32_t const record[3] = { name, tinfo, node };
+  write(EventKind::Missing, record, sizeof(record));
+}
+
+void EventLog::partial(
+  NameIDType name, NameIDType tinfo, StackNodeIDType node, uint64_t bytes,
+  uint64_t total
+) {
+  std::lock_guard<std::mutex> guard{mutex_};
+  defineName(name);
+  defineName(tinfo);
+  defineNode(node);
+  uint32_t const ids[3] = { name, tinfo, node };
+  uint64_t const sizes[2] = { bytes, total };
+  write(EventKind::Partial, ids, sizeof(ids), sizes, sizeof(sizes));
+}
+
+}} /* end namespace checkpoint::sanitizer */
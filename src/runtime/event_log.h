@@ -0,0 +1,192 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 event_log.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_EVENT_LOG_H
+#define INCLUDED_SANITIZER_RUNTIME_EVENT_LOG_H
+
+#include "runtime_interface.h"
+#include "call_stack_trie.h"
+#include "name_table.h"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/*
+ * Event log format. The file starts with an \c EventLogHeader followed by
+ * records, each an \c EventRecordHeader and \c size bytes of payload. Integers
+ * are in host byte order. A record kind of 0 ends the log: a process that is
+ * killed leaves the zero-filled tail of the last mapped segment behind.
+ *
+ *  - \c EventKind::Name: u32 id, then the name (not NUL-terminated)
+ *  - \c EventKind::Node: u32 id, u32 parent, u32 type name id
+ *  - \c EventKind::Missing: u32 name id, u32 type name id, u32 node
+ *  - \c EventKind::Partial: u32 name id, u32 type name id, u32 node,
+ *    u64 bytes serialized, u64 bytes of the member
+ *
+ * A name or node is defined by a record before the first record that refers
+ * to it.
+ */
+
+/// Magic bytes at the start of an event log
+static constexpr char const event_log_magic[8] = {
+  'V', 'T', 'S', 'A', 'N', 'L', 'O', 'G'
+};
+
+/// Version of the event log format
+static constexpr uint32_t const event_log_version = 1;
+
+enum struct EventKind : uint16_t {
+  End     = 0,
+  Name    = 1,
+  Node    = 2,
+  Missing = 3,
+  Partial = 4
+};
+
+struct EventLogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t pid;
+};
+
+struct EventRecordHeader {
+  uint16_t kind;
+  uint16_t reserved;
+  uint32_t size;
+};
+
+/**
+ * \struct EventLog
+ *
+ * \brief Append-only log of missing-member events written through a
+ * memory-mapped window of the file, so events are durable as soon as they are
+ * recorded (even if the process is killed) and memory use is bounded by the
+ * window. Names and call-stack nodes are written the first time an event
+ * refers to them.
+ */
+struct EventLog {
+
+  /**
+   * \brief Open a log file, truncating it
+   *
+   * \param[in] path the file
+   * \param[in] names the name table the logged IDs refer to
+   * \param[in] stacks the trie the logged nodes refer to
+   */
+  EventLog(
+    std::string const& path, NameTable const& names,
+    CallStackTrie const& stacks
+  );
+
+  ~EventLog();
+
+  EventLog(EventLog const&) = delete;
+  EventLog& operator=(EventLog const&) = delete;
+
+  /**
+   * \brief Whether the log file is open
+   */
+  bool isOpen() const { return fd_ >= 0; }
+
+  std::string const& getPath() const { return path_; }
+
+  /**
+   * \brief Log an instance of a missing member
+   *
+   * \param[in] name the member name
+   * \param[in] tinfo the member type
+   * \param[in] node the call stack the member was reached through
+   */
+  void missing(NameIDType name, NameIDType tinfo, StackNodeIDType node);
+
+  /**
+   * \brief Log an instance of a partially serialized member
+   *
+   * \param[in] name the member name
+   * \param[in] tinfo the member type
+   * \param[in] node the call stack the member was reached through
+   * \param[in] bytes the bytes of the member serialized
+   * \param[in] total the bytes of the member
+   */
+  void partial(
+    NameIDType name, NameIDType tinfo, StackNodeIDType node, uint64_t bytes,
+    uint64_t total
+  );
+
+private:
+  void defineName(NameIDType id);
+  void defineNode(StackNodeIDType node);
+  void write(EventKind kind, void const* a, std::size_t a_len,
+             void const* b = nullptr, std::size_t b_len = 0);
+  bool reserve(std::size_t len);
+
+private:
+  /// Size of the window of the file mapped at a time
+  static constexpr std::size_t const window_size = 4 << 20;
+
+  std::string path_;
+  NameTable const& names_;
+  CallStackTrie const& stacks_;
+  /// Serializes writers
+  std::mutex mutex_;
+  int fd_ = -1;
+  /// Mapped window of the file
+  char* window_ = nullptr;
+  /// File offset of the start of \c window_
+  std::size_t window_offset_ = 0;
+  /// File offset of the end of the log
+  std::size_t offset_ = 0;
+  /// Names and nodes already defined in the log
+  std::vector<bool> names_written_;
+  std::vector<bool> nodes_written_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_EVENT_LOG_H*/
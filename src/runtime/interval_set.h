@@ -0,0 +1,171 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                interval_set.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_INTERVAL_SET_H
+#define INCLUDED_SANITIZER_RUNTIME_INTERVAL_SET_H
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct Interval
+ *
+ * \brief A half-open range of addresses [begin, end)
+ */
+struct Interval {
+  uintptr_t begin = 0;
+  uintptr_t end = 0;
+};
+
+/**
+ * \struct IntervalSet
+ *
+ * \brief Set of disjoint, sorted address intervals. Overlapping and adjacent
+ * intervals are merged on insertion. Serializers mostly visit memory in
+ * ascending order, so an insertion usually extends or appends to the last
+ * interval.
+ */
+struct IntervalSet {
+
+  /**
+   * \brief Remove all intervals, retaining capacity
+   */
+  void clear() { intervals_.clear(); }
+
+  bool empty() const { return intervals_.empty(); }
+
+  std::vector<Interval> const& getIntervals() const { return intervals_; }
+
+  /**
+   * \brief Insert an interval, merging it with the ones it overlaps or abuts
+   *
+   * \param[in] begin the first address
+   * \param[in] end one past the last address
+   */
+  void insert(uintptr_t begin, uintptr_t end) {
+    if (begin >= end) {
+      return;
+    }
+
+    // fast path: at or past the last interval
+    if (intervals_.empty() or begin > intervals_.back().end) {
+      intervals_.push_back(Interval{begin, end});
+      return;
+    }
+    if (begin >= intervals_.back().begin) {
+      intervals_.back().end = std::max(intervals_.back().end, end);
+      return;
+    }
+
+    // first interval that ends at or after begin, and first that starts after end
+    auto first = std::lower_bound(
+      intervals_.begin(), intervals_.end(), begin,
+      [](Interval const& i, uintptr_t a) { return i.end < a; }
+    );
+    auto last = std::upper_bound(
+      first, intervals_.end(), end,
+      [](uintptr_t a, Interval const& i) { return a < i.begin; }
+    );
+    if (first == last) {
+      intervals_.insert(first, Interval{begin, end});
+      return;
+    }
+    first->begin = std::min(first->begin, begin);
+    first->end = std::max((last - 1)->end, end);
+    intervals_.erase(first + 1, last);
+  }
+
+  /**
+   * \brief Whether an address falls in any interval
+   *
+   * \param[in] addr the address
+   *
+   * \return whether it is contained
+   */
+  bool contains(uintptr_t addr) const {
+    auto iter = std::upper_bound(
+      intervals_.begin(), intervals_.end(), addr,
+      [](uintptr_t a, Interval const& i) { return a < i.begin; }
+    );
+    return iter != intervals_.begin() and addr < (iter - 1)->end;
+  }
+
+  /**
+   * \brief Apply a function to the number of bytes of each of a sequence of
+   * ascending, disjoint ranges that fall in the set, in one sweep over both
+   *
+   * \param[in] count the number of ranges
+   * \param[in] range function returning the i-th range as an \c Interval
+   * \param[in] fn function called with the index of each range and the
+   * number of its bytes in the set
+   */
+  template <typename RangeFn, typename Fn>
+  void sweep(std::size_t count, RangeFn&& range, Fn&& fn) const {
+    std::size_t r = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      Interval const m = range(i);
+      while (r < intervals_.size() and intervals_[r].end <= m.begin) {
+        r++;
+      }
+      uintptr_t bytes = 0;
+      for (auto k = r; k < intervals_.size() and intervals_[k].begin < m.end; k++) {
+        bytes += std::min(intervals_[k].end, m.end) -
+          std::max(intervals_[k].begin, m.begin);
+      }
+      fn(i, static_cast<std::size_t>(bytes));
+    }
+  }
+
+private:
+  /// Disjoint intervals sorted by address
+  std::vector<Interval> intervals_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_INTERVAL_SET_H*/
@@ -45,76 +45,153 @@
 #if !defined INCLUDED_SANITIZER_RUNTIME_MISSING_INFO_H
 #define INCLUDED_SANITIZER_RUNTIME_MISSING_INFO_H
 
+#include "runtime_interface.h"
+#include "call_stack_trie.h"
+
 #include <vector>
-#include <string>
+#include <array>
+#include <unordered_map>
+#include <mutex>
 
 namespace checkpoint { namespace sanitizer {
 
-struct CallStack {
-  using StackType = std::vector<std::string>;
+/**
+ * \struct MissingInfo
+ *
+ * \brief A member the serializer missed, with the number of instances
+ * reached through each distinct call stack
+ */
+struct MissingInfo {
 
-  explicit CallStack(StackType const& in_stack)
-    : stack_(in_stack),
-      instances_(1)
+  MissingInfo(NameIDType in_name, NameIDType in_tinfo)
+    : name_(in_name),
+      tinfo_(in_tinfo)
   { }
 
-  bool isSame(StackType const& in) const {
-    if (stack_.size() != in.size()) {
-      return false;
-    }
-    for (std::size_t i = 0; i < stack_.size(); i++) {
-      if (in.at(i) != stack_.at(i)) {
-        return false;
-      }
-    }
-    return true;
+  void addStack(StackNodeIDType stack, uint64_t num = 1) {
+    instances_ += num;
+    stacks_[stack] += num;
   }
 
-  void addInstance() { instances_++; }
+  /**
+   * \brief Accumulate the bytes serialized of an instance that was only
+   * partially serialized
+   *
+   * \param[in] bytes the bytes serialized
+   * \param[in] total the bytes of the member
+   */
+  void addCoverage(uint64_t bytes, uint64_t total) {
+    covered_bytes_ += bytes;
+    total_bytes_ += total;
+  }
 
-  int getInstances() const { return instances_; }
+  /**
+   * \brief The percentage of the bytes of the instances that was serialized
+   */
+  double getCoverage() const {
+    return total_bytes_ == 0 ? 0.0 : 100.0 * covered_bytes_ / total_bytes_;
+  }
 
-  StackType const& getStack() const { return stack_; }
+  uint64_t getCoveredBytes() const { return covered_bytes_; }
+  uint64_t getTotalBytes() const { return total_bytes_; }
+  uint64_t getInstances() const { return instances_; }
+  NameIDType getName() const { return name_; }
+  NameIDType getTinfo() const { return tinfo_; }
+  std::unordered_map<StackNodeIDType, uint64_t> const& getStacks() const {
+    return stacks_;
+  }
 
 private:
-  StackType stack_;
-  int instances_ = 0;
+  NameIDType name_ = no_name_id;
+  NameIDType tinfo_ = no_name_id;
+  /// Instances for each distinct call stack, by its node in the trie
+  std::unordered_map<StackNodeIDType, uint64_t> stacks_;
+  uint64_t instances_ = 0;
+  /// Bytes serialized over all partially serialized instances
+  uint64_t covered_bytes_ = 0;
+  /// Bytes of the member over all partially serialized instances
+  uint64_t total_bytes_ = 0;
 };
 
-struct MissingInfo {
-  using StackType = std::vector<std::string>;
-
-  MissingInfo(
-    std::string const& in_name, std::string const& in_tinfo,
-    StackType const& in_stack
-  ) : name_(in_name),
-      tinfo_(in_tinfo)
-  {
-    addStack(in_stack);
+/**
+ * \struct MissingRegistry
+ *
+ * \brief Concurrent registry of missing members, sharded by member name so
+ * threads recording different members rarely contend. Recording an instance
+ * is a hash lookup and an increment.
+ */
+struct MissingRegistry {
+
+  /**
+   * \brief Record an instance of a missing member
+   *
+   * \param[in] name the member name
+   * \param[in] tinfo the member type
+   * \param[in] stack the trie node of the call stack the member was reached
+   * through
+   * \param[in] num the number of instances
+   */
+  void add(
+    NameIDType name, NameIDType tinfo, StackNodeIDType stack, uint64_t num = 1
+  ) {
+    auto& shard = shards_[name % num_registry_shards];
+    std::lock_guard<std::mutex> guard{shard.mutex};
+    find(shard, name, tinfo).addStack(stack, num);
   }
 
-  void addStack(StackType const& in_stack) {
-    instances_++;
+  /**
+   * \brief Record an instance of a partially serialized member
+   *
+   * \param[in] name the member name
+   * \param[in] tinfo the member type
+   * \param[in] stack the trie node of the call stack the member was reached
+   * through
+   * \param[in] bytes the bytes of the member serialized
+   * \param[in] total the bytes of the member
+   */
+  void addPartial(
+    NameIDType name, NameIDType tinfo, StackNodeIDType stack, uint64_t bytes,
+    uint64_t total
+  ) {
+    auto& shard = shards_[name % num_registry_shards];
+    std::lock_guard<std::mutex> guard{shard.mutex};
+    auto& info = find(shard, name, tinfo);
+    info.addStack(stack);
+    info.addCoverage(bytes, total);
+  }
 
-    for (auto&& s : stacks_) {
-      if (s.isSame(in_stack)) {
-        s.addInstance();
-        return;
+  /**
+   * \brief Get a copy of all the missing members recorded so far
+   *
+   * \return the missing members
+   */
+  std::vector<MissingInfo> snapshot() const {
+    std::vector<MissingInfo> out;
+    for (auto&& shard : shards_) {
+      std::lock_guard<std::mutex> guard{shard.mutex};
+      for (auto&& e : shard.missing) {
+        out.push_back(e.second);
       }
     }
-    stacks_.emplace_back(CallStack{in_stack});
+    return out;
   }
 
-  int getInstances() const { return instances_; }
-  std::string const& getName() const { return name_; }
-  std::string const& getTinfo() const { return tinfo_; }
-  std::vector<CallStack> const& getStacks() const { return stacks_; }
+private:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<NameIDType, MissingInfo> missing;
+  };
+
+  static MissingInfo& find(Shard& shard, NameIDType name, NameIDType tinfo) {
+    auto iter = shard.missing.find(name);
+    if (iter == shard.missing.end()) {
+      iter = shard.missing.emplace(name, MissingInfo{name, tinfo}).first;
+    }
+    return iter->second;
+  }
 
 private:
-  std::string name_ = "";
-  std::string tinfo_ = "";
-  std::vector<CallStack> stacks_;
-  int instances_ = 0;
+  std::array<Shard, num_registry_shards> shards_;
 };
 
 }} /* end namespace checkpoint::sanitizer */
@@ -0,0 +1,151 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               mpi_transport.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "rank_reduce.h"
+
+#if SANITIZER_HAS_MPI
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace checkpoint { namespace sanitizer {
+
+namespace {
+
+/// Largest message sent at once; longer buffers are sent in chunks
+static constexpr std::size_t const max_chunk = INT_MAX;
+
+struct MPITransport : RankTransport {
+
+  explicit MPITransport(MPI_Comm in_comm) : comm_(in_comm) {
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+  }
+
+  ~MPITransport() {
+    MPI_Comm_free(&comm_);
+  }
+
+  int rank() const override { return rank_; }
+  int size() const override { return size_; }
+
+  bool send(int dest, std::string const& buf) override {
+    uint64_t len = buf.size();
+    if (MPI_Send(&len, 1, MPI_UINT64_T, dest, 0, comm_) != MPI_SUCCESS) {
+      return false;
+    }
+    for (std::size_t pos = 0; pos < buf.size(); pos += max_chunk) {
+      auto const count = static_cast<int>(std::min(max_chunk, buf.size() - pos));
+      if (
+        MPI_Send(buf.data() + pos, count, MPI_BYTE, dest, 0, comm_) !=
+        MPI_SUCCESS
+      ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool recv(int src, std::string& buf) override {
+    uint64_t len = 0;
+    if (
+      MPI_Recv(&len, 1, MPI_UINT64_T, src, 0, comm_, MPI_STATUS_IGNORE) !=
+      MPI_SUCCESS
+    ) {
+      return false;
+    }
+    buf.resize(len);
+    for (std::size_t pos = 0; pos < buf.size(); pos += max_chunk) {
+      auto const count = static_cast<int>(std::min(max_chunk, buf.size() - pos));
+      if (
+        MPI_Recv(
+          &buf[pos], count, MPI_BYTE, src, 0, comm_, MPI_STATUS_IGNORE
+        ) != MPI_SUCCESS
+      ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  MPI_Comm comm_ = MPI_COMM_NULL;
+  int rank_ = 0;
+  int size_ = 1;
+};
+
+} /* end anon namespace */
+
+std::unique_ptr<RankTransport> makeMPITransport() {
+  int initialized = 0, finalized = 0;
+  MPI_Initialized(&initialized);
+  MPI_Finalized(&finalized);
+  if (not initialized or finalized) {
+    return nullptr;
+  }
+
+  // a private communicator keeps the reduction apart from application traffic
+  MPI_Comm comm = MPI_COMM_NULL;
+  if (MPI_Comm_dup(MPI_COMM_WORLD, &comm) != MPI_SUCCESS) {
+    return nullptr;
+  }
+  return std::make_unique<MPITransport>(comm);
+}
+
+}} /* end namespace checkpoint::sanitizer */
+
+#else /* SANITIZER_HAS_MPI */
+
+namespace checkpoint { namespace sanitizer {
+
+std::unique_ptr<RankTransport> makeMPITransport() {
+  return nullptr;
+}
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /* SANITIZER_HAS_MPI */
@@ -0,0 +1,234 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 name_table.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_NAME_TABLE_H
+#define INCLUDED_SANITIZER_RUNTIME_NAME_TABLE_H
+
+#include "runtime_interface.h"
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <cstring>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct NameIndex
+ *
+ * \brief Flat open-addressing map from a name (by precomputed hash and
+ * content) to its interned ID. Probing never allocates; the index only stores
+ * pointers to names that outlive it.
+ */
+struct NameIndex {
+
+  NameIndex()
+    : slots_(initial_capacity)
+  { }
+
+  /**
+   * \brief Find the ID for a name
+   *
+   * \param[in] str the name
+   * \param[in] hash the hash of the name
+   *
+   * \return the ID or \c no_name_id if not present
+   */
+  NameIDType find(char const* str, uint64_t hash) const {
+    return slots_[probe(slots_, str, hash)].id;
+  }
+
+  /**
+   * \brief Insert a name that is not present
+   *
+   * \param[in] str the name, which must outlive the index
+   * \param[in] hash the hash of the name
+   * \param[in] id the ID for the name
+   */
+  void insert(char const* str, uint64_t hash, NameIDType id) {
+    // keep the load factor at or below one half
+    if ((count_ + 1) * 2 > slots_.size()) {
+      std::vector<Slot> grown(slots_.size() * 2);
+      for (auto&& s : slots_) {
+        if (s.id != no_name_id) {
+          grown[probe(grown, s.str, s.hash)] = s;
+        }
+      }
+      std::swap(grown, slots_);
+    }
+    slots_[probe(slots_, str, hash)] = Slot{hash, str, id};
+    count_++;
+  }
+
+private:
+  struct Slot {
+    uint64_t hash = 0;
+    char const* str = nullptr;
+    NameIDType id = no_name_id;
+  };
+
+  static std::size_t probe(
+    std::vector<Slot> const& slots, char const* str, uint64_t hash
+  ) {
+    auto const mask = slots.size() - 1;
+    for (auto i = static_cast<std::size_t>(hash) & mask; ; i = (i + 1) & mask) {
+      auto const& s = slots[i];
+      if (s.id == no_name_id) {
+        return i;
+      }
+      if (s.hash == hash and (s.str == str or std::strcmp(s.str, str) == 0)) {
+        return i;
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t const initial_capacity = 256;
+
+  /// Open-addressed slots; size is always a power of two
+  std::vector<Slot> slots_;
+  /// Number of occupied slots
+  std::size_t count_ = 0;
+};
+
+/**
+ * \struct NameTable
+ *
+ * \brief Process-wide table that interns member and type names to dense IDs.
+ * Access is serialized by a mutex; threads keep a \c NameIndex in front of it
+ * so the table is only consulted the first time a thread sees a name. The
+ * string is only copied for names arriving through the \c std::string hooks,
+ * once per distinct name.
+ */
+struct NameTable {
+
+  NameTable() {
+    // ID 0 is reserved for \c no_name_id
+    names_.push_back("");
+  }
+
+  NameTable(NameTable const&) = delete;
+  NameTable& operator=(NameTable const&) = delete;
+
+  /**
+   * \brief Intern a name with static storage duration
+   *
+   * \param[in] name the static name
+   *
+   * \return the ID for the name
+   */
+  NameIDType intern(StaticName const& name) {
+    std::lock_guard<std::mutex> guard{mutex_};
+    auto id = index_.find(name.str, name.hash);
+    if (id == no_name_id) {
+      id = insert(name.str, name.hash);
+    }
+    return id;
+  }
+
+  /**
+   * \brief Intern a name that does not outlive the call (compatibility path)
+   *
+   * \param[in] name the name
+   *
+   * \return the ID for the name
+   */
+  NameIDType intern(std::string const& name) {
+    auto const hash = hashName(name.c_str());
+    std::lock_guard<std::mutex> guard{mutex_};
+    auto id = index_.find(name.c_str(), hash);
+    if (id == no_name_id) {
+      std::unique_ptr<char[]> copy{new char[name.size() + 1]};
+      std::memcpy(copy.get(), name.c_str(), name.size() + 1);
+      owned_.emplace_back(std::move(copy));
+      id = insert(owned_.back().get(), hash);
+    }
+    return id;
+  }
+
+  /**
+   * \brief Get the name for an interned ID; the storage is stable for the
+   * lifetime of the table
+   *
+   * \param[in] id the ID
+   *
+   * \return the name
+   */
+  char const* getName(NameIDType id) const {
+    std::lock_guard<std::mutex> guard{mutex_};
+    return names_.at(id);
+  }
+
+  /**
+   * \brief Get the number of names interned
+   *
+   * \return the number of names
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> guard{mutex_};
+    return names_.size() - 1;
+  }
+
+private:
+  NameIDType insert(char const* str, uint64_t hash) {
+    auto const id = static_cast<NameIDType>(names_.size());
+    names_.push_back(str);
+    index_.insert(str, hash, id);
+    return id;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  /// Index from name to ID
+  NameIndex index_;
+  /// Interned names indexed by ID
+  std::vector<char const*> names_;
+  /// Storage for names that did not come with static storage duration
+  std::vector<std::unique_ptr<char[]>> owned_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_NAME_TABLE_H*/
@@ -43,7 +43,9 @@
 */
 
 #include "common.h"
+#include "config.h"
 #include "preload.h"
+#include "rank_reduce.h"
 #include "sanitize_rt.h"
 
 #include <stdlib.h>
@@ -58,6 +60,7 @@ namespace checkpoint { namespace sanitizer {
   } name
 
 SANITIZER_HOOK(MPI_Init);
+SANITIZER_HOOK(MPI_Finalize);
 SANITIZER_HOOK(checkpoint_sanitizer_rt);
 SANITIZER_HOOK(checkpoint_sanitizer_enabled);
 
@@ -83,20 +86,12 @@ int MPI_Init(int *argc, char ***argv) {
   }
 #endif
 
-  char* to_file = getenv("VT_SANITIZE_OUTPUT_FILE");
-  if (to_file != nullptr) {
-    auto str = std::string{to_file};
-    if (str == "1" or str == "ON" or str == "on" or str == "true" or str == "TRUE") {
-      checkpoint::sanitizer::output_as_file = true;
-    }
+  if (checkpoint::sanitizer::envFlagOn("VT_SANITIZE_OUTPUT_FILE")) {
+    checkpoint::sanitizer::output_as_file = true;
   }
 
-  char* to_colorize = getenv("VT_SANITIZE_OUTPUT_COLORIZE");
-  if (to_colorize != nullptr) {
-    auto str = std::string{to_colorize};
-    if (str == "0" or str == "OFF" or str == "off" or str == "false" or str == "FALSE") {
-      checkpoint::sanitizer::output_colorize = false;
-    }
+  if (checkpoint::sanitizer::envFlagOff("VT_SANITIZE_OUTPUT_COLORIZE")) {
+    checkpoint::sanitizer::output_colorize = false;
   }
 
   if (checkpoint::sanitizer::MPI_Init) {
@@ -120,20 +115,53 @@ int MPI_Init(int *argc, char ***argv) {
   }
 }
 
-checkpoint::sanitizer::Runtime* checkpoint_sanitizer_rt() {
-  debug_sanitizer("Intercepted checkpoint_sanitizer_rt\n");
+int MPI_Finalize() {
+  checkpoint::sanitizer::MPI_Finalize.init();
 
-  static std::unique_ptr<checkpoint::sanitizer::Sanitizer> active_rt = nullptr;
+  debug_sanitizer("Intercepted MPI_Finalize\n");
 
-  if (active_rt == nullptr) {
-    active_rt = std::make_unique<checkpoint::sanitizer::Sanitizer>();
+  // reduce the reports to rank 0 while MPI is still usable
+  {
+    auto transport = checkpoint::sanitizer::makeMPITransport();
+    if (transport != nullptr) {
+      auto rt = static_cast<checkpoint::sanitizer::Sanitizer*>(
+        checkpoint_sanitizer_rt()
+      );
+      rt->reduceAcrossRanks(*transport);
+    }
   }
+
+  return checkpoint::sanitizer::MPI_Finalize();
+}
+
+checkpoint::sanitizer::Runtime* checkpoint_sanitizer_rt() {
+  debug_sanitizer("Intercepted checkpoint_sanitizer_rt\n");
+
+  // function-local static: construction is thread-safe on first use
+  static auto active_rt = std::make_unique<checkpoint::sanitizer::Sanitizer>();
   return active_rt.get();
 }
 
 bool checkpoint_sanitizer_enabled() {
   debug_sanitizer("Intercepted checkpoint_sanitizer_enabled\n");
-  return true;
+  return checkpoint::sanitizer::sanitizeActive();
+}
+
+std::atomic<bool> const* checkpoint_sanitizer_enabled_flag() {
+  return &checkpoint::sanitizer::sanitize_active;
+}
+
+void checkpoint_sanitizer_set_enabled(bool enabled) {
+  checkpoint::sanitizer::setSanitizeActive(enabled);
+}
+
+uint64_t checkpoint_sanitizer_begin_phase() {
+  auto const phase = checkpoint::sanitizer::beginSanitizePhase();
+  debug_sanitizer(
+    "Phase {}: sanitization {}\n", phase,
+    checkpoint::sanitizer::sanitizeActive() ? "on" : "off"
+  );
+  return phase;
 }
 
 } /* end extern "C" */
@@ -46,6 +46,7 @@
 #define INCLUDED_SANITIZER_RUNTIME_PRELOAD_H
 
 #include "sanitize_rt.h"
+#include "control.h"
 
 #include <dlfcn.h>
 
@@ -90,8 +91,35 @@ public:
 
 extern "C" int MPI_Init(int *argc, char ***argv);
 
+extern "C" int MPI_Finalize();
+
 extern "C" checkpoint::sanitizer::Runtime* checkpoint_sanitizer_rt();
 
 extern "C" bool checkpoint_sanitizer_enabled();
 
+/**
+ * \brief Get the flag read by \c checkpoint_sanitizer_enabled. The address
+ * is fixed for the lifetime of the process: a serializer that keeps it and
+ * loads it (relaxed) before each serialization pays a single predictable
+ * branch while sanitization is off.
+ *
+ * \return the flag
+ */
+extern "C" std::atomic<bool> const* checkpoint_sanitizer_enabled_flag();
+
+/**
+ * \brief Turn sanitization on or off at runtime
+ *
+ * \param[in] enabled whether sanitization is on
+ */
+extern "C" void checkpoint_sanitizer_set_enabled(bool enabled);
+
+/**
+ * \brief Start the next phase of the application (e.g., a checkpoint); with
+ * \c VT_SANITIZE_PHASES, sanitization is on only during the selected phases
+ *
+ * \return the number of the phase started, from 1
+ */
+extern "C" uint64_t checkpoint_sanitizer_begin_phase();
+
 #endif /*INCLUDED_SANITIZER_RUNTIME_PRELOAD_H*/
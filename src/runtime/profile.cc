@@ -0,0 +1,153 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  profile.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "profile.h"
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace checkpoint { namespace sanitizer {
+
+namespace {
+
+/// Pipe from the signal handler to the watcher thread
+int signal_pipe[2] = {-1, -1};
+/// Handler in place before \c ProfileSignal::start
+struct sigaction previous_action;
+
+/// Byte written by the handler for each signal
+constexpr char const signal_byte = 'S';
+
+void onSignal(int) {
+  auto const saved = errno;
+  auto const ret = write(signal_pipe[1], &signal_byte, 1);
+  static_cast<void>(ret);
+  errno = saved;
+}
+
+} /* end anon namespace */
+
+char const* hookKindName(HookKind kind) {
+  switch (kind) {
+  case HookKind::CheckMember:  return "checkMember";
+  case HookKind::SkipMember:   return "skipMember";
+  case HookKind::IsSerialized: return "isSerialized";
+  case HookKind::Push:         return "push";
+  case HookKind::Pop:          return "pop";
+  case HookKind::CheckLayout:  return "checkLayout";
+  }
+  return "unknown";
+}
+
+uint64_t ThreadProfile::insideNs() const {
+  auto const timed = timed_calls.load(std::memory_order_relaxed);
+  if (timed == 0) {
+    return 0;
+  }
+  auto const ns = static_cast<double>(timed_ns.load(std::memory_order_relaxed));
+  return static_cast<uint64_t>(ns / timed * totalCalls());
+}
+
+uint64_t ThreadProfile::totalCalls() const {
+  uint64_t total = 0;
+  for (auto&& c : calls) {
+    total += c.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+bool ProfileSignal::start(int signum, std::function<void()> callback) {
+  if (signum_ != 0 or signal_pipe[0] != -1 or pipe(signal_pipe) != 0) {
+    return false;
+  }
+  fcntl(signal_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(signal_pipe[1], F_SETFD, FD_CLOEXEC);
+  // a full pipe drops the signal rather than blocking the interrupted thread
+  fcntl(signal_pipe[1], F_SETFL, O_NONBLOCK);
+
+  struct sigaction action = {};
+  action.sa_handler = onSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(signum, &action, &previous_action) != 0) {
+    close(signal_pipe[0]);
+    close(signal_pipe[1]);
+    signal_pipe[0] = signal_pipe[1] = -1;
+    return false;
+  }
+  signum_ = signum;
+
+  auto const fd = signal_pipe[0];
+  watcher_ = std::thread([fd, callback]{
+    char c = 0;
+    while (true) {
+      auto const ret = read(fd, &c, 1);
+      if (ret < 0 and errno == EINTR) {
+        continue;
+      }
+      if (ret != 1 or c != signal_byte) {
+        break;
+      }
+      callback();
+    }
+  });
+  return true;
+}
+
+void ProfileSignal::stop() {
+  if (signum_ == 0) {
+    return;
+  }
+  // the watcher sees end of file once the handler can no longer write
+  sigaction(signum_, &previous_action, nullptr);
+  close(signal_pipe[1]);
+  watcher_.join();
+  close(signal_pipe[0]);
+  signal_pipe[0] = signal_pipe[1] = -1;
+  signum_ = 0;
+}
+
+}} /* end namespace checkpoint::sanitizer */
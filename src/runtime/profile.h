@@ -0,0 +1,234 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  profile.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_PROFILE_H
+#define INCLUDED_SANITIZER_RUNTIME_PROFILE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \brief The kinds of runtime hooks counted by the self-profile
+ */
+enum struct HookKind : uint8_t {
+  CheckMember = 0,
+  SkipMember,
+  IsSerialized,
+  Push,
+  Pop,
+  CheckLayout
+};
+
+/// Number of \c HookKind values
+static constexpr std::size_t const num_hook_kinds = 6;
+
+/**
+ * \brief Get the name of a hook kind as printed in the profile
+ *
+ * \param[in] kind the hook kind
+ *
+ * \return the name
+ */
+char const* hookKindName(HookKind kind);
+
+/**
+ * \brief Get a monotonic timestamp in nanoseconds
+ */
+inline uint64_t profileNow() {
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count()
+  );
+}
+
+/**
+ * \struct ThreadProfile
+ *
+ * \brief Self-profiling counters of one thread. Only the owning thread
+ * writes them, with relaxed loads and stores that compile to plain moves, so
+ * a dump from another thread reads them without locking. The time spent in
+ * hooks is measured on one call out of \c period and extrapolated.
+ */
+struct ThreadProfile {
+
+  explicit ThreadProfile(uint64_t in_period)
+    : period(in_period),
+      countdown(in_period),
+      start_ns(profileNow())
+  {
+    for (auto&& c : calls) {
+      c.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * \brief Add to a counter owned by this thread
+   *
+   * \param[in,out] counter the counter
+   * \param[in] n the amount
+   */
+  static void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(
+      counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed
+    );
+  }
+
+  /**
+   * \brief Record the depth of the stack after a push
+   *
+   * \param[in] depth the depth
+   */
+  void depth(uint64_t depth) {
+    if (depth > max_depth.load(std::memory_order_relaxed)) {
+      max_depth.store(depth, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * \brief The estimated time spent in hooks, extrapolated from the timed
+   * calls
+   */
+  uint64_t insideNs() const;
+
+  /**
+   * \brief The total number of hook calls
+   */
+  uint64_t totalCalls() const;
+
+  /// Hook calls by \c HookKind
+  std::array<std::atomic<uint64_t>, num_hook_kinds> calls;
+  /// Deepest stack of frames seen by the thread
+  std::atomic<uint64_t> max_depth{0};
+  /// Members checked, including each entry of a layout table
+  std::atomic<uint64_t> checks{0};
+  /// Hook calls that were timed and the nanoseconds spent in them
+  std::atomic<uint64_t> timed_calls{0};
+  std::atomic<uint64_t> timed_ns{0};
+  /// Time one hook call out of \c period; never when 0
+  uint64_t const period = 0;
+  /// Hook calls left before the next timed one
+  uint64_t countdown = 0;
+  /// When the thread invoked its first hook
+  uint64_t const start_ns = 0;
+};
+
+/**
+ * \struct ProfileScope
+ *
+ * \brief Counts a hook call for the lifetime of the hook, timing it when
+ * its turn in the sampling period comes up
+ */
+struct ProfileScope {
+
+  ProfileScope(ThreadProfile& in_profile, HookKind kind)
+    : profile_(in_profile)
+  {
+    ThreadProfile::bump(profile_.calls[static_cast<std::size_t>(kind)]);
+    if (profile_.countdown != 0 and --profile_.countdown == 0) {
+      profile_.countdown = profile_.period;
+      start_ = profileNow();
+    }
+  }
+
+  ProfileScope(ProfileScope const&) = delete;
+  ProfileScope& operator=(ProfileScope const&) = delete;
+
+  ~ProfileScope() {
+    if (start_ != 0) {
+      ThreadProfile::bump(profile_.timed_ns, profileNow() - start_);
+      ThreadProfile::bump(profile_.timed_calls);
+    }
+  }
+
+private:
+  ThreadProfile& profile_;
+  uint64_t start_ = 0;
+};
+
+/**
+ * \struct ProfileSignal
+ *
+ * \brief Runs a callback on a watcher thread each time a signal is
+ * delivered to the process. The handler only writes to a pipe, so the
+ * callback is free to lock and allocate; the signal no longer terminates the
+ * process. At most one watcher is installed at a time.
+ */
+struct ProfileSignal {
+
+  ProfileSignal() = default;
+  ProfileSignal(ProfileSignal const&) = delete;
+  ProfileSignal& operator=(ProfileSignal const&) = delete;
+
+  ~ProfileSignal() { stop(); }
+
+  /**
+   * \brief Install the signal handler and start the watcher thread
+   *
+   * \param[in] signum the signal
+   * \param[in] callback invoked on the watcher thread for each signal
+   *
+   * \return whether the handler was installed
+   */
+  bool start(int signum, std::function<void()> callback);
+
+  /**
+   * \brief Restore the previous handler and join the watcher thread
+   */
+  void stop();
+
+private:
+  int signum_ = 0;
+  std::thread watcher_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_PROFILE_H*/
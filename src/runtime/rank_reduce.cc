@@ -0,0 +1,81 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                rank_reduce.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "rank_reduce.h"
+
+#include <fmt/format.h>
+
+namespace checkpoint { namespace sanitizer {
+
+bool reduceReport(Report& report, RankTransport& transport) {
+  auto const rank = transport.rank();
+  auto const size = transport.size();
+
+  for (int mask = 1; mask < size; mask <<= 1) {
+    if ((rank & mask) != 0) {
+      std::string buf;
+      report.serialize(buf);
+      if (not transport.send(rank - mask, buf)) {
+        fmt::print(stderr, "Sanitizer: rank {} failed to send its report\n", rank);
+      }
+      return false;
+    }
+
+    auto const child = rank + mask;
+    if (child < size) {
+      std::string buf, error;
+      Report other;
+      if (not transport.recv(child, buf)) {
+        fmt::print(stderr, "Sanitizer: failed to receive report of rank {}\n", child);
+      } else if (not other.deserialize(buf, error)) {
+        fmt::print(stderr, "Sanitizer: report of rank {}: {}\n", child, error);
+      } else {
+        report.merge(other);
+      }
+    }
+  }
+  return rank == 0;
+}
+
+}} /* end namespace checkpoint::sanitizer */
@@ -0,0 +1,115 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                rank_reduce.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_RANK_REDUCE_H
+#define INCLUDED_SANITIZER_RUNTIME_RANK_REDUCE_H
+
+#include "report.h"
+
+#include <memory>
+#include <string>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct RankTransport
+ *
+ * \brief Point-to-point exchange of byte buffers between the ranks of a
+ * parallel job, used to reduce the reports of all ranks at shutdown
+ */
+struct RankTransport {
+
+  virtual ~RankTransport() = default;
+
+  /// The rank of the calling process
+  virtual int rank() const = 0;
+
+  /// The number of ranks
+  virtual int size() const = 0;
+
+  /**
+   * \brief Send a buffer to another rank
+   *
+   * \param[in] dest the destination rank
+   * \param[in] buf the buffer
+   *
+   * \return whether the buffer was sent
+   */
+  virtual bool send(int dest, std::string const& buf) = 0;
+
+  /**
+   * \brief Receive a buffer sent by another rank
+   *
+   * \param[in] src the source rank
+   * \param[out] buf the buffer
+   *
+   * \return whether a buffer was received
+   */
+  virtual bool recv(int src, std::string& buf) = 0;
+};
+
+/**
+ * \brief Reduce the reports of all ranks to rank 0 along a binomial tree:
+ * each rank merges the serialized reports of its children and sends the
+ * result to its parent, so rank 0 receives \c log2(size) messages.
+ *
+ * \param[in,out] report the report of the calling rank; on rank 0, the
+ * merged report of all ranks
+ * \param[in] transport the transport between the ranks
+ *
+ * \return whether the calling rank is rank 0 and holds the merged report
+ */
+bool reduceReport(Report& report, RankTransport& transport);
+
+/**
+ * \brief Create the MPI transport over a duplicate of \c MPI_COMM_WORLD
+ *
+ * \return the transport, or \c nullptr if the runtime was built without MPI
+ * or MPI is not initialized
+ */
+std::unique_ptr<RankTransport> makeMPITransport();
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_RANK_REDUCE_H*/
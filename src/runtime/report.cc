@@ -0,0 +1,402 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  report.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "report.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace checkpoint { namespace sanitizer {
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T const& value) {
+  out.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+struct Cursor {
+  std::string const& buf;
+  std::size_t pos = 0;
+  bool ok = true;
+
+  template <typename T>
+  T get() {
+    T value{};
+    if (pos + sizeof(T) > buf.size()) {
+      ok = false;
+      return value;
+    }
+    std::memcpy(&value, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  std::string getString(std::size_t len) {
+    if (pos + len > buf.size()) {
+      ok = false;
+      return "";
+    }
+    pos += len;
+    return buf.substr(pos - len, len);
+  }
+
+  /// Whether \c count items of at least \c size bytes can remain
+  bool fits(uint64_t count, std::size_t size) {
+    ok = ok and count <= (buf.size() - pos) / size;
+    return ok;
+  }
+};
+
+inline uint64_t pairKey(uint32_t a, uint32_t b) {
+  return static_cast<uint64_t>(a) << 32 | b;
+}
+
+} /* end anon namespace */
+
+bool isReport(std::string const& buf) {
+  return buf.size() >= sizeof(report_magic) and
+    std::memcmp(buf.data(), report_magic, sizeof(report_magic)) == 0;
+}
+
+uint32_t Report::addString(std::string const& str) {
+  auto iter = string_index_.find(str);
+  if (iter != string_index_.end()) {
+    return iter->second;
+  }
+  auto const idx = static_cast<uint32_t>(strings.size());
+  strings.push_back(str);
+  string_index_.emplace(str, idx);
+  return idx;
+}
+
+uint32_t Report::addNode(uint32_t parent, uint32_t tinfo) {
+  auto const key = pairKey(parent, tinfo);
+  auto iter = node_index_.find(key);
+  if (iter != node_index_.end()) {
+    return iter->second;
+  }
+  auto const idx = static_cast<uint32_t>(nodes.size());
+  nodes.push_back(Node{parent, tinfo});
+  node_index_.emplace(key, idx);
+  return idx;
+}
+
+uint32_t Report::add(
+  uint32_t name, uint32_t tinfo, bool partial, uint32_t node,
+  uint64_t instances, uint64_t bytes, uint64_t total
+) {
+  auto const entry_key = static_cast<uint64_t>(name) << 1 | (partial ? 1 : 0);
+  auto iter = entry_index_.find(entry_key);
+  if (iter == entry_index_.end()) {
+    iter = entry_index_.emplace(
+      entry_key, static_cast<uint32_t>(entries.size())
+    ).first;
+    Entry entry;
+    entry.name = name;
+    entry.tinfo = tinfo;
+    entry.partial = partial;
+    entries.push_back(std::move(entry));
+  }
+  auto& entry = entries[iter->second];
+  entry.instances += instances;
+  entry.bytes += bytes;
+  entry.total += total;
+
+  auto const stack_key = pairKey(iter->second, node);
+  auto siter = stack_index_.find(stack_key);
+  if (siter == stack_index_.end()) {
+    siter = stack_index_.emplace(
+      stack_key, static_cast<uint32_t>(entry.stacks.size())
+    ).first;
+    entry.stacks.push_back(Stack{node, 0});
+  }
+  entry.stacks[siter->second].instances += instances;
+  return iter->second;
+}
+
+void Report::setRank(uint32_t rank) {
+  for (auto&& e : entries) {
+    std::size_t bin = 0;
+    while (bin + 1 < report_histogram_bins and (e.instances >> (bin + 1)) != 0) {
+      bin++;
+    }
+    e.ranks = 1;
+    e.first_rank = rank;
+    e.histogram.fill(0);
+    e.histogram[bin] = 1;
+  }
+}
+
+void Report::merge(Report const& other) {
+  pids.insert(pids.end(), other.pids.begin(), other.pids.end());
+  frames_pushed += other.frames_pushed;
+  frames_reused += other.frames_reused;
+
+  std::vector<uint32_t> str_map(other.strings.size());
+  for (std::size_t i = 0; i < other.strings.size(); i++) {
+    str_map[i] = addString(other.strings[i]);
+  }
+
+  // parents always precede their children
+  std::vector<uint32_t> node_map(other.nodes.size());
+  for (std::size_t i = 0; i < other.nodes.size(); i++) {
+    auto const& n = other.nodes[i];
+    auto const parent = n.parent == report_root_node ?
+      report_root_node : node_map[n.parent];
+    node_map[i] = addNode(parent, str_map[n.tinfo]);
+  }
+
+  for (auto&& e : other.entries) {
+    bool first = true;
+    uint32_t idx = 0;
+    for (auto&& st : e.stacks) {
+      auto const node = st.node == report_root_node ?
+        report_root_node : node_map[st.node];
+      idx = add(
+        str_map[e.name], str_map[e.tinfo], e.partial, node, st.instances,
+        first ? e.bytes : 0, first ? e.total : 0
+      );
+      first = false;
+    }
+    if (first) {
+      continue;
+    }
+    auto& entry = entries[idx];
+    entry.first_rank = entry.ranks == 0 ?
+      e.first_rank : std::min(entry.first_rank, e.first_rank);
+    entry.ranks += e.ranks;
+    for (std::size_t i = 0; i < report_histogram_bins; i++) {
+      entry.histogram[i] += e.histogram[i];
+    }
+  }
+}
+
+void Report::serialize(std::string& out) const {
+  std::size_t size = sizeof(report_magic) + 64 + pids.size() * 4 +
+    nodes.size() * 8;
+  for (auto&& s : strings) {
+    size += 4 + s.size();
+  }
+  for (auto&& e : entries) {
+    size += 50 + report_histogram_bins * 4 + e.stacks.size() * 12;
+  }
+  out.reserve(out.size() + size);
+
+  out.append(report_magic, sizeof(report_magic));
+  put(out, report_version);
+  put(out, frames_pushed);
+  put(out, frames_reused);
+  put(out, static_cast<uint32_t>(pids.size()));
+  for (auto&& p : pids) {
+    put(out, p);
+  }
+  put(out, static_cast<uint32_t>(strings.size()));
+  for (auto&& s : strings) {
+    put(out, static_cast<uint32_t>(s.size()));
+    out.append(s);
+  }
+  put(out, static_cast<uint32_t>(nodes.size()));
+  for (auto&& n : nodes) {
+    put(out, n.parent);
+    put(out, n.tinfo);
+  }
+  put(out, static_cast<uint32_t>(entries.size()));
+  for (auto&& e : entries) {
+    put(out, e.name);
+    put(out, e.tinfo);
+    put(out, static_cast<uint8_t>(e.partial ? 1 : 0));
+    put(out, e.instances);
+    put(out, e.bytes);
+    put(out, e.total);
+    put(out, e.ranks);
+    put(out, e.first_rank);
+    auto bins = report_histogram_bins;
+    while (bins > 0 and e.histogram[bins - 1] == 0) {
+      bins--;
+    }
+    put(out, static_cast<uint8_t>(bins));
+    for (std::size_t i = 0; i < bins; i++) {
+      put(out, e.histogram[i]);
+    }
+    put(out, static_cast<uint32_t>(e.stacks.size()));
+    for (auto&& st : e.stacks) {
+      put(out, st.node);
+      put(out, st.instances);
+    }
+  }
+}
+
+bool Report::deserialize(std::string const& buf, std::string& error) {
+  *this = Report{};
+  if (not isReport(buf)) {
+    error = "not a sanitizer report";
+    return false;
+  }
+
+  Cursor in{buf, sizeof(report_magic)};
+  auto const version = in.get<uint32_t>();
+  if (in.ok and version != report_version) {
+    error = "unsupported report version " + std::to_string(version);
+    return false;
+  }
+  frames_pushed = in.get<uint64_t>();
+  frames_reused = in.get<uint64_t>();
+
+  auto const num_pids = in.get<uint32_t>();
+  for (uint32_t i = 0; in.fits(num_pids - i, 4) and i < num_pids; i++) {
+    pids.push_back(in.get<uint32_t>());
+  }
+  auto const num_strings = in.get<uint32_t>();
+  for (uint32_t i = 0; in.fits(num_strings - i, 4) and i < num_strings; i++) {
+    strings.push_back(in.getString(in.get<uint32_t>()));
+  }
+  auto const num_nodes = in.get<uint32_t>();
+  for (uint32_t i = 0; in.fits(num_nodes - i, 8) and i < num_nodes; i++) {
+    Node n;
+    n.parent = in.get<uint32_t>();
+    n.tinfo = in.get<uint32_t>();
+    in.ok = in.ok and n.tinfo < strings.size() and
+      (n.parent == report_root_node or n.parent < i);
+    nodes.push_back(n);
+  }
+  auto const num_entries = in.get<uint32_t>();
+  for (uint32_t i = 0; in.fits(num_entries - i, 50) and i < num_entries; i++) {
+    Entry e;
+    e.name = in.get<uint32_t>();
+    e.tinfo = in.get<uint32_t>();
+    e.partial = in.get<uint8_t>() != 0;
+    e.instances = in.get<uint64_t>();
+    e.bytes = in.get<uint64_t>();
+    e.total = in.get<uint64_t>();
+    e.ranks = in.get<uint32_t>();
+    e.first_rank = in.get<uint32_t>();
+    auto const bins = in.get<uint8_t>();
+    in.ok = in.ok and bins <= report_histogram_bins;
+    for (std::size_t j = 0; in.ok and j < bins; j++) {
+      e.histogram[j] = in.get<uint32_t>();
+    }
+    in.ok = in.ok and e.name < strings.size() and e.tinfo < strings.size();
+    auto const num_stacks = in.get<uint32_t>();
+    for (uint32_t j = 0; in.fits(num_stacks - j, 12) and j < num_stacks; j++) {
+      Stack st;
+      st.node = in.get<uint32_t>();
+      st.instances = in.get<uint64_t>();
+      in.ok = in.ok and (st.node == report_root_node or st.node < nodes.size());
+      e.stacks.push_back(st);
+    }
+    entries.push_back(std::move(e));
+  }
+
+  if (not in.ok) {
+    *this = Report{};
+    error = "truncated or corrupt sanitizer report";
+    return false;
+  }
+  reindex();
+  return true;
+}
+
+void Report::reindex() {
+  string_index_.clear();
+  node_index_.clear();
+  entry_index_.clear();
+  stack_index_.clear();
+  for (std::size_t i = 0; i < strings.size(); i++) {
+    string_index_.emplace(strings[i], static_cast<uint32_t>(i));
+  }
+  for (std::size_t i = 0; i < nodes.size(); i++) {
+    node_index_.emplace(
+      pairKey(nodes[i].parent, nodes[i].tinfo), static_cast<uint32_t>(i)
+    );
+  }
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    auto const& e = entries[i];
+    entry_index_.emplace(
+      static_cast<uint64_t>(e.name) << 1 | (e.partial ? 1 : 0),
+      static_cast<uint32_t>(i)
+    );
+    for (std::size_t j = 0; j < e.stacks.size(); j++) {
+      stack_index_.emplace(
+        pairKey(static_cast<uint32_t>(i), e.stacks[j].node),
+        static_cast<uint32_t>(j)
+      );
+    }
+  }
+}
+
+std::vector<SummaryMember> Report::toSummary() const {
+  std::vector<SummaryMember> members;
+  members.reserve(entries.size());
+  for (auto&& e : entries) {
+    SummaryMember member;
+    member.name = strings[e.name];
+    member.tinfo = strings[e.tinfo];
+    member.instances = e.instances;
+    member.partial = e.partial;
+    member.coverage = e.total == 0 ? 0.0 : 100.0 * e.bytes / e.total;
+    member.ranks = e.ranks;
+    member.first_rank = e.first_rank;
+    for (std::size_t i = 0; i < report_histogram_bins; i++) {
+      if (e.histogram[i] != 0) {
+        member.histogram.push_back(
+          SummaryBin{uint64_t{1} << i, (uint64_t{2} << i) - 1, e.histogram[i]}
+        );
+      }
+    }
+    for (auto&& st : e.stacks) {
+      SummaryStack stack;
+      for (auto n = st.node; n != report_root_node; n = nodes[n].parent) {
+        stack.frames.push_back(strings[nodes[n].tinfo]);
+      }
+      stack.instances = st.instances;
+      member.stacks.push_back(std::move(stack));
+    }
+    members.push_back(std::move(member));
+  }
+  sortSummary(members);
+  return members;
+}
+
+}} /* end namespace checkpoint::sanitizer */
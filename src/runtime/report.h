@@ -0,0 +1,233 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                   report.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_REPORT_H
+#define INCLUDED_SANITIZER_RUNTIME_REPORT_H
+
+#include "summary.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/*
+ * Binary report format. Integers are in host byte order.
+ *
+ *   header:   char[8] "VTSANRPT", u32 version
+ *   counters: u64 frames pushed, u64 frames reused
+ *   pids:     u32 count, u32 pid...
+ *   strings:  u32 count, (u32 length, bytes)...
+ *   nodes:    u32 count, (u32 parent, u32 type string)...
+ *   entries:  u32 count, (u32 name string, u32 type string, u8 partial,
+ *             u64 instances, u64 bytes serialized, u64 bytes total,
+ *             u32 ranks, u32 first rank, u8 bins, u32 ranks per bin...,
+ *             u32 stack count, (u32 node, u64 instances)...)...
+ *
+ * A node's parent is the index of an earlier node or \c report_root_node.
+ * Histogram bin \c k counts the ranks on which the member had between
+ * \c 2^k and \c 2^(k+1)-1 instances; trailing empty bins are not stored.
+ */
+
+/// Magic bytes at the start of a binary report
+static constexpr char const report_magic[8] = {
+  'V', 'T', 'S', 'A', 'N', 'R', 'P', 'T'
+};
+
+/// Version of the binary report format
+static constexpr uint32_t const report_version = 2;
+
+/// Number of bins of the per-rank instance histogram of a \c Report entry
+static constexpr std::size_t const report_histogram_bins = 32;
+
+/// Parent of the outermost stack nodes in a \c Report
+static constexpr uint32_t const report_root_node = static_cast<uint32_t>(-1);
+
+/**
+ * \struct Report
+ *
+ * \brief Self-contained, compact table of the missing and partially
+ * serialized members of one or more processes: names and types are indices
+ * into a string table and call stacks are nodes of a prefix tree. Reports
+ * serialize to one contiguous buffer and merge by content.
+ */
+struct Report {
+
+  struct Node {
+    uint32_t parent = report_root_node;
+    uint32_t tinfo = 0;
+  };
+
+  struct Stack {
+    uint32_t node = report_root_node;
+    uint64_t instances = 0;
+  };
+
+  struct Entry {
+    uint32_t name = 0;
+    uint32_t tinfo = 0;
+    bool partial = false;
+    uint64_t instances = 0;
+    /// Bytes serialized and total bytes, over partially serialized instances
+    uint64_t bytes = 0;
+    uint64_t total = 0;
+    /// Number of ranks the member was found on and the lowest of them
+    uint32_t ranks = 0;
+    uint32_t first_rank = 0;
+    /// Ranks by log2 of their instances of the member
+    std::array<uint32_t, report_histogram_bins> histogram = {};
+    std::vector<Stack> stacks;
+  };
+
+  /**
+   * \brief Get the index of a string, adding it to the string table
+   *
+   * \param[in] str the string
+   *
+   * \return the index
+   */
+  uint32_t addString(std::string const& str);
+
+  /**
+   * \brief Get the index of a stack node, adding it to the node table
+   *
+   * \param[in] parent the parent node or \c report_root_node
+   * \param[in] tinfo the index of the type name of the frame
+   *
+   * \return the index
+   */
+  uint32_t addNode(uint32_t parent, uint32_t tinfo);
+
+  /**
+   * \brief Add instances of a member reached through a stack, accumulating
+   * into the entry for the same member, type and kind
+   *
+   * \param[in] name the index of the member name
+   * \param[in] tinfo the index of the member type
+   * \param[in] partial whether the member was partially serialized
+   * \param[in] node the stack node
+   * \param[in] instances the number of instances
+   * \param[in] bytes the bytes serialized, when partial
+   * \param[in] total the bytes of the member, when partial
+   *
+   * \return the index of the entry
+   */
+  uint32_t add(
+    uint32_t name, uint32_t tinfo, bool partial, uint32_t node,
+    uint64_t instances, uint64_t bytes = 0, uint64_t total = 0
+  );
+
+  /**
+   * \brief Merge another report into this one
+   *
+   * \param[in] other the report
+   */
+  void merge(Report const& other);
+
+  /**
+   * \brief Attribute all entries to one rank, resetting their rank counts
+   * and histograms; done once on the report of each process before merging
+   *
+   * \param[in] rank the rank of the process
+   */
+  void setRank(uint32_t rank);
+
+  /**
+   * \brief Append the binary form of the report to a buffer
+   *
+   * \param[in,out] out the buffer
+   */
+  void serialize(std::string& out) const;
+
+  /**
+   * \brief Read a report from its binary form
+   *
+   * \param[in] buf the buffer
+   * \param[out] error the error if the buffer is not a valid report
+   *
+   * \return whether the report was read
+   */
+  bool deserialize(std::string const& buf, std::string& error);
+
+  /**
+   * \brief Expand the report into the members printed in a summary, sorted
+   *
+   * \return the members
+   */
+  std::vector<SummaryMember> toSummary() const;
+
+  std::vector<uint32_t> pids;
+  uint64_t frames_pushed = 0;
+  uint64_t frames_reused = 0;
+  std::vector<std::string> strings;
+  std::vector<Node> nodes;
+  std::vector<Entry> entries;
+
+private:
+  void reindex();
+
+private:
+  /// String to its index
+  std::unordered_map<std::string, uint32_t> string_index_;
+  /// (parent, type) to the node index
+  std::unordered_map<uint64_t, uint32_t> node_index_;
+  /// (name, partial) to the entry index
+  std::unordered_map<uint64_t, uint32_t> entry_index_;
+  /// (entry, node) to the position in the entry's stacks
+  std::unordered_map<uint64_t, uint32_t> stack_index_;
+};
+
+/**
+ * \brief Whether a buffer starts like a binary report
+ *
+ * \param[in] buf the buffer
+ */
+bool isReport(std::string const& buf);
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_REPORT_H*/
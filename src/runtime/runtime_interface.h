@@ -47,9 +47,84 @@
 
 #include <string>
 #include <memory>
+#include <typeinfo>
+#include <cstddef>
+#include <cstdint>
 
 namespace checkpoint { namespace sanitizer {
 
+/// Identifier for a name (member or type) interned by the sanitizer runtime
+using NameIDType = uint32_t;
+
+/// Sentinel ID that never refers to an interned name
+static constexpr NameIDType const no_name_id = 0;
+
+/**
+ * \brief Hash a NUL-terminated name (FNV-1a); usable at compile-time
+ *
+ * \param[in] str the name to hash
+ *
+ * \return the hash of the name
+ */
+constexpr uint64_t hashName(char const* str) {
+  uint64_t hash = 14695981039346656037ull;
+  for (; *str != '\0'; ++str) {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned char>(*str));
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * \struct StaticName
+ *
+ * \brief A name with static storage duration (string literal, type info name)
+ * paired with its precomputed hash. The runtime resolves it to an interned ID
+ * without copying the string.
+ */
+struct StaticName {
+
+  explicit constexpr StaticName(char const* in_str)
+    : str(in_str),
+      hash(hashName(in_str))
+  { }
+
+  constexpr StaticName(char const* in_str, uint64_t in_hash)
+    : str(in_str),
+      hash(in_hash)
+  { }
+
+  char const* str = nullptr;
+  uint64_t hash = 0;
+};
+
+/**
+ * \struct MemberLayout
+ *
+ * \brief An entry of a member layout table generated at compile time for a
+ * class: the offset and size of a member with its static name and type name.
+ * \c data_size excludes the padding inside the member; it is the number of
+ * bytes that must be serialized for the member to be fully covered.
+ */
+struct MemberLayout {
+  std::size_t offset = 0;
+  std::size_t size = 0;
+  std::size_t data_size = 0;
+  StaticName name;
+  StaticName tinfo;
+};
+
+/**
+ * \brief Get the static name for a type; the hash is computed once per type
+ *
+ * \return the static name of \c T
+ */
+template <typename T>
+inline StaticName const& staticTypeName() {
+  static StaticName const name{typeid(T).name()};
+  return name;
+}
+
 /**
  * \struct Runtime
  *
@@ -100,6 +175,97 @@ struct Runtime {
    */
   virtual void pop(std::string tinfo) {}
 
+  /*
+   * Allocation-free hooks: names are passed as \c StaticName and must outlive
+   * the runtime. By default they forward to the \c std::string hooks so
+   * runtimes that only implement those keep working.
+   */
+
+  /**
+   * \brief Check that a member is serialized
+   *
+   * \param[in] addr the memory address of the element
+   * \param[in] name the static name of the element
+   * \param[in] tinfo the static typeinfo name of the element
+   */
+  virtual void checkMember(void* addr, StaticName name, StaticName tinfo) {
+    checkMember(addr, std::string{name.str}, std::string{tinfo.str});
+  }
+
+  /**
+   * \brief Inform sanitizer that a member's serialization is skipped
+   *
+   * \param[in] addr the memory address of the element
+   * \param[in] name the static name of the element
+   * \param[in] tinfo the static typeinfo name of the element
+   */
+  virtual void skipMember(void* addr, StaticName name, StaticName tinfo) {
+    skipMember(addr, std::string{name.str}, std::string{tinfo.str});
+  }
+
+  /**
+   * \brief Inform sanitizer that a member is serialized
+   *
+   * \param[in] addr the memory address of the element
+   * \param[in] num the number of elements
+   * \param[in] tinfo the static typeinfo name of the element
+   */
+  virtual void isSerialized(void* addr, std::size_t num, StaticName tinfo) {
+    isSerialized(addr, num, std::string{tinfo.str});
+  }
+
+  /**
+   * \brief Inform sanitizer that a contiguous block of elements is serialized;
+   * every member in the \c num * \c size bytes starting at \c addr counts as
+   * serialized
+   *
+   * \param[in] addr the memory address of the first element
+   * \param[in] num the number of elements
+   * \param[in] size the size of an element in bytes
+   * \param[in] tinfo the static typeinfo name of the element
+   */
+  virtual void isSerialized(
+    void* addr, std::size_t num, std::size_t /*size*/, StaticName tinfo
+  ) {
+    isSerialized(addr, num, tinfo);
+  }
+
+  /**
+   * \brief Check that every member in a generated layout table is serialized
+   *
+   * \param[in] base the memory address of the object
+   * \param[in] layout the layout table of the object's class
+   * \param[in] count the number of entries in the table
+   */
+  virtual void checkLayout(
+    void* base, MemberLayout const* layout, std::size_t count
+  ) {
+    for (std::size_t i = 0; i < count; i++) {
+      checkMember(
+        static_cast<char*>(base) + layout[i].offset, layout[i].name,
+        layout[i].tinfo
+      );
+    }
+  }
+
+  /**
+   * \brief Push a stack frame of the current serializer context we are entering
+   *
+   * \param[in] tinfo the static name of the type recursed into
+   */
+  virtual void push(StaticName tinfo) {
+    push(std::string{tinfo.str});
+  }
+
+  /**
+   * \brief Pop a stack frame of the current serializer context we are leaving
+   *
+   * \param[in] tinfo the static name of the type recursed out of
+   */
+  virtual void pop(StaticName tinfo) {
+    pop(std::string{tinfo.str});
+  }
+
 };
 
 /// pimpl to runtime that contains runtime sanitizer logic
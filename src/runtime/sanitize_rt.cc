@@ -44,168 +44,765 @@
 
 #include "common.h"
 #include "sanitize_rt.h"
+#include "summary.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <atomic>
+#include <unordered_map>
 #include <unistd.h>
-#include <cxxabi.h>
 
 namespace checkpoint { namespace sanitizer {
 
 bool output_as_file = false;
 bool output_colorize = true;
 
+namespace {
+
+/**
+ * \struct LiveRuntimes
+ *
+ * \brief The runtimes that are alive, so a thread that exits after its
+ * runtime was destroyed does not touch it. Never destroyed, since threads may
+ * exit during static destruction.
+ */
+struct LiveRuntimes {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Sanitizer*> runtimes;
+};
+
+LiveRuntimes& liveRuntimes() {
+  static auto live = new LiveRuntimes;
+  return *live;
+}
+
+/**
+ * \struct HookGate
+ *
+ * \brief Which live objects of a thread are not sanitized, and the thread's
+ * sampling state, kept apart from \c ThreadState so that the hooks of an
+ * object that is not sanitized cost one thread-local load
+ */
+struct HookGate {
+  /// Number of live objects sanitized
+  std::size_t depth = 0;
+  /// Number of live objects not sanitized: an object pushed while
+  /// sanitization was off or sampled out, and every object nested in it
+  std::size_t skip_depth = 0;
+  /// The runtime that \c sampler and \c state belong to
+  uint64_t instance = 0;
+  /// The state of the thread in that runtime
+  ThreadState* state = nullptr;
+  /// Sampling state of the types pushed by the thread
+  TypeSampler sampler;
+};
+
+thread_local HookGate gate;
+
+/**
+ * \brief Whether the hooks of the calling thread have nothing to do
+ */
+inline bool hooksOff() {
+  return gate.skip_depth > 0;
+}
+
+/**
+ * \brief Leave an object on the calling thread
+ *
+ * \return whether the object was not sanitized
+ */
+inline bool leaveObject() {
+  if (gate.skip_depth > 0) {
+    gate.skip_depth--;
+    return true;
+  }
+  assert(gate.depth > 0 && "Unmatched pop of stack");
+  gate.depth--;
+  return false;
+}
+
+} /* end anon namespace */
+
+Sanitizer::Sanitizer()
+  : sample_(SampleConfig::fromEnv()),
+    cache_(CacheConfig::fromEnv()),
+    profile_(ProfileConfig::fromEnv()),
+    start_ns_(profileNow())
+{
+  static std::atomic<uint64_t> next_instance{1};
+  instance_ = next_instance.fetch_add(1);
+  {
+    auto& live = liveRuntimes();
+    std::lock_guard<std::mutex> guard{live.mutex};
+    live.runtimes[instance_] = this;
+  }
+  if (LogConfig::fromEnv().enabled) {
+    log_ = std::make_unique<EventLog>(
+      fmt::format("{}.sanitize.log", getpid()), names_, stacks_
+    );
+  }
+  if (profile_.enabled and profile_.signum != 0) {
+    profile_signal_.start(profile_.signum, [this]{ printProfile(); });
+  }
+  debug_sanitizer("Constructing sanitizer runtime\n");
+}
+
+Sanitizer::~Sanitizer() {
+  debug_sanitizer("Destroying sanitizer runtime\n");
+  {
+    auto& live = liveRuntimes();
+    std::lock_guard<std::mutex> guard{live.mutex};
+    live.runtimes.erase(instance_);
+  }
+  profile_signal_.stop();
+  if (profile_.enabled) {
+    printProfile();
+  }
+  printSummary();
+}
+
+bool Sanitizer::enterObject(char const* tinfo, uint64_t hash) {
+  if (gate.skip_depth > 0) {
+    gate.skip_depth++;
+    return true;
+  }
+  // the flag is read once per outermost object so that toggling it never
+  // splits a serialization; nested objects follow the outermost one
+  if (gate.depth == 0 and not sanitizeActive()) {
+    serializations_disabled_.fetch_add(1, std::memory_order_relaxed);
+    gate.skip_depth = 1;
+    return true;
+  }
+  if (sample_.enabled() and not sampleObject(tinfo, hash)) {
+    ThreadProfile::bump(gate.state->frames_skipped);
+    gate.skip_depth = 1;
+    return true;
+  }
+  gate.depth++;
+  return false;
+}
+
+ThreadState& Sanitizer::local() {
+  struct Cached {
+    ~Cached() { retireThread(instance, state); }
+
+    uint64_t instance = 0;
+    ThreadState* state = nullptr;
+  };
+  static thread_local Cached cached;
+
+  if (cached.instance != instance_) {
+    retireThread(cached.instance, cached.state);
+    std::lock_guard<std::mutex> guard{threads_mutex_};
+    threads_.emplace_back(std::make_unique<ThreadState>(profile_.period));
+    cached.instance = instance_;
+    cached.state = threads_.back().get();
+  }
+  return *cached.state;
+}
+
+/*static*/ void Sanitizer::retireThread(uint64_t instance, ThreadState* state) {
+  if (state == nullptr) {
+    return;
+  }
+
+  // hold the registry lock so the runtime cannot be destroyed meanwhile
+  auto& live = liveRuntimes();
+  std::lock_guard<std::mutex> live_guard{live.mutex};
+  auto iter = live.runtimes.find(instance);
+  if (iter == live.runtimes.end()) {
+    return;
+  }
+
+  auto rt = iter->second;
+  std::lock_guard<std::mutex> guard{rt->threads_mutex_};
+  rt->retired_.add(*state, profileNow());
+  auto slot = std::find_if(
+    rt->threads_.begin(), rt->threads_.end(),
+    [state](std::unique_ptr<ThreadState> const& t) { return t.get() == state; }
+  );
+  if (slot != rt->threads_.end()) {
+    std::swap(*slot, rt->threads_.back());
+    rt->threads_.pop_back();
+  }
+}
+
+ThreadTotals Sanitizer::totals() {
+  auto const now = profileNow();
+  std::lock_guard<std::mutex> guard{threads_mutex_};
+  auto sum = retired_;
+  for (auto&& t : threads_) {
+    sum.add(*t, now);
+  }
+  return sum;
+}
+
+NameIDType Sanitizer::intern(ThreadState& ts, StaticName const& name) {
+  auto id = ts.names.find(name.str, name.hash);
+  if (id == no_name_id) {
+    id = names_.intern(name);
+    ts.names.insert(name.str, name.hash, id);
+  }
+  return id;
+}
+
+NameIDType Sanitizer::intern(ThreadState& ts, std::string const& name) {
+  auto const hash = hashName(name.c_str());
+  auto id = ts.names.find(name.c_str(), hash);
+  if (id == no_name_id) {
+    id = names_.intern(name);
+    ts.names.insert(names_.getName(id), hash, id);
+  }
+  return id;
+}
+
 void Sanitizer::checkMember(void* addr, std::string name, std::string tinfo) {
-  assert(stack_.size() > 0 && "Must have valid live stack");
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::CheckMember};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Checked, [&]{
+    return DeferredHook{addr, Checked, intern(ts, name), intern(ts, tinfo)};
+  })) {
+    return;
+  }
+  checkMemberImpl(ts, addr, intern(ts, name), intern(ts, tinfo));
+}
+
+void Sanitizer::skipMember(void* addr, std::string name, std::string tinfo) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::SkipMember};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Ignored, [&]{
+    return DeferredHook{addr, Ignored, intern(ts, name), intern(ts, tinfo)};
+  })) {
+    return;
+  }
+  skipMemberImpl(ts, addr, intern(ts, name), intern(ts, tinfo));
+}
+
+void Sanitizer::isSerialized(void* addr, std::size_t num, std::string tinfo) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::IsSerialized};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Serialized, [&]{
+    return DeferredHook{addr, Serialized, no_name_id, intern(ts, tinfo)};
+  })) {
+    return;
+  }
+  isSerializedImpl(ts, addr, num, 0, intern(ts, tinfo));
+}
+
+void Sanitizer::push(std::string tinfo) {
+  auto const hash = sample_.enabled() ? hashName(tinfo.c_str()) : 0;
+  if (enterObject(tinfo.c_str(), hash)) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::Push};
+  pushImpl(ts, intern(ts, tinfo));
+}
+
+void Sanitizer::pop(std::string tinfo) {
+  if (leaveObject()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::Pop};
+  if (ts.mode() != FrameMode::Check) {
+    popUnchecked(ts);
+    return;
+  }
+  popImpl(ts, intern(ts, tinfo));
+}
+
+void Sanitizer::checkMember(void* addr, StaticName name, StaticName tinfo) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::CheckMember};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Checked, [&]{
+    return DeferredHook{addr, Checked, name, tinfo};
+  })) {
+    return;
+  }
+  checkMemberImpl(ts, addr, intern(ts, name), intern(ts, tinfo));
+}
+
+void Sanitizer::skipMember(void* addr, StaticName name, StaticName tinfo) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::SkipMember};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Ignored, [&]{
+    return DeferredHook{addr, Ignored, name, tinfo};
+  })) {
+    return;
+  }
+  skipMemberImpl(ts, addr, intern(ts, name), intern(ts, tinfo));
+}
+
+void Sanitizer::isSerialized(void* addr, std::size_t num, StaticName tinfo) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::IsSerialized};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Serialized, [&]{
+    return DeferredHook{addr, Serialized, StaticName{nullptr, 0}, tinfo};
+  })) {
+    return;
+  }
+  isSerializedImpl(ts, addr, num, 0, intern(ts, tinfo));
+}
+
+void Sanitizer::isSerialized(
+  void* addr, std::size_t num, std::size_t size, StaticName tinfo
+) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::IsSerialized};
+  ThreadProfile::bump(ts.profile.checks);
+  if (ts.shortCircuit(addr, Serialized, [&]{
+    DeferredHook hook{addr, Serialized, StaticName{nullptr, 0}, tinfo};
+    hook.bytes = num * size;
+    return hook;
+  })) {
+    return;
+  }
+  isSerializedImpl(ts, addr, num, size, intern(ts, tinfo));
+}
+
+void Sanitizer::push(StaticName tinfo) {
+  if (enterObject(tinfo.str, tinfo.hash)) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::Push};
+  pushImpl(ts, intern(ts, tinfo));
+}
+
+void Sanitizer::pop(StaticName tinfo) {
+  if (leaveObject()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::Pop};
+  if (ts.mode() != FrameMode::Check) {
+    popUnchecked(ts);
+    return;
+  }
+  popImpl(ts, intern(ts, tinfo));
+}
+
+void Sanitizer::checkLayout(
+  void* base, MemberLayout const* layout, std::size_t count
+) {
+  if (hooksOff()) {
+    return;
+  }
+  auto& ts = local();
+  ProfileScope scope{ts.profile, HookKind::CheckLayout};
+  ThreadProfile::bump(ts.profile.checks, count);
+  assert(ts.depth > 0 && "Must have valid live stack");
+  auto& frame = ts.stack[ts.depth - 1];
+  auto const addr = static_cast<char*>(base);
+  debug_sanitizer(
+    "checkLayout: {}, count={}: size={}\n", static_cast<void const*>(base),
+    count, ts.depth
+  );
+
+  // one pass over the contiguous table; a fingerprinted frame only mixes in
+  // the offsets and keeps the table for replay
+  if (frame.getMode() == FrameMode::Fingerprint) {
+    for (std::size_t i = 0; i < count; i++) {
+      frame.fingerprint(addr + layout[i].offset, Checked);
+    }
+    frame.defer(DeferredHook{base, layout, count});
+    return;
+  }
+  checkLayoutImpl(ts, base, layout, count);
+}
+
+void Sanitizer::checkLayoutImpl(
+  ThreadState& ts, void* base, MemberLayout const* layout, std::size_t count
+) {
+  auto& frame = ts.stack[ts.depth - 1];
+  auto const addr = static_cast<char*>(base);
+
+  // members at known offsets go to the frame's bitset; the frame table is
+  // the fallback when the layout cannot be indexed
+  if (frame.setLayout(base, layout, count)) {
+    return;
+  }
+  for (std::size_t i = 0; i < count; i++) {
+    auto const& m = layout[i];
+    frame.checkElm(addr + m.offset, intern(ts, m.name), intern(ts, m.tinfo));
+  }
+}
+
+void Sanitizer::checkMemberImpl(
+  ThreadState& ts, void* addr, NameIDType name, NameIDType tinfo
+) {
+  assert(ts.depth > 0 && "Must have valid live stack");
   debug_sanitizer(
     "check: {}, name={}, tinfo={}: size={}\n",
-    static_cast<void const*>(addr), name, tinfo, stack_.size()
+    static_cast<void const*>(addr), names_.getName(name),
+    names_.getName(tinfo), ts.depth
   );
-  stack_.back().checkElm(addr, name, tinfo);
+  ts.stack[ts.depth - 1].checkElm(addr, name, tinfo);
 }
 
-void Sanitizer::skipMember(void* addr, std::string name, std::string tinfo) {
-  assert(stack_.size() > 0 && "Must have valid live stack");
+void Sanitizer::skipMemberImpl(
+  ThreadState& ts, void* addr, NameIDType name, NameIDType tinfo
+) {
+  assert(ts.depth > 0 && "Must have valid live stack");
   debug_sanitizer(
     "skip: {}, name={}, tinfo={}: size={}\n",
-    static_cast<void const*>(addr), name, tinfo, stack_.size()
+    static_cast<void const*>(addr), names_.getName(name),
+    names_.getName(tinfo), ts.depth
   );
-  stack_.back().ignoreElm(addr, name, tinfo);
+  ts.stack[ts.depth - 1].ignoreElm(addr, name, tinfo);
 }
 
-void Sanitizer::isSerialized(void* addr, std::size_t num, std::string tinfo) {
+void Sanitizer::isSerializedImpl(
+  ThreadState& ts, void* addr, std::size_t num, std::size_t size,
+  NameIDType tinfo
+) {
   // At a top-level, nothing to do!
-  if (stack_.size() == 0) {
+  if (ts.depth == 0) {
     return;
   }
   debug_sanitizer(
-    "isSerialized: {}, num={}. tinfo={}: size={}\n",
-    static_cast<void const*>(addr), num, tinfo, stack_.size()
+    "isSerialized: {}, num={}, bytes={}. tinfo={}: size={}\n",
+    static_cast<void const*>(addr), num, num * size, names_.getName(tinfo),
+    ts.depth
   );
-  stack_.back().isSerialized(addr, tinfo);
+  ts.stack[ts.depth - 1].isSerialized(addr, num * size, tinfo);
 }
 
-void Sanitizer::push(std::string tinfo) {
-  stack_.push_back(StackRecord{tinfo});
-  debug_sanitizer("push: tinfo={} : level={}\n", tinfo, stack_.size());
+bool Sanitizer::sampleObject(char const* tinfo, uint64_t hash) {
+  if (gate.instance != instance_) {
+    gate.sampler.clear();
+    gate.instance = instance_;
+    gate.state = &local();
+  }
+
+  // only the first object of a type on the thread interns the type
+  auto slot = gate.sampler.find(tinfo, hash);
+  if (slot == nullptr) {
+    auto const id = intern(*gate.state, std::string{tinfo});
+    slot = &gate.sampler.insert(names_.getName(id), hash, &types_.get(id));
+  }
+  return gate.sampler.select(*slot, sample_);
 }
 
-void Sanitizer::pop(std::string tinfo) {
-  debug_sanitizer("pop: tinfo={} : level={}\n", tinfo, stack_.size());
+void Sanitizer::pushImpl(ThreadState& ts, NameIDType tinfo) {
+  auto mode = FrameMode::Check;
+  if (
+    cache_.enabled() and
+    types_.get(tinfo).proven.load(std::memory_order_relaxed)
+  ) {
+    mode = FrameMode::Fingerprint;
+  }
+
+  // reuse a pooled frame at this depth when available, retaining capacity
+  if (ts.depth < ts.stack.size()) {
+    ts.stack[ts.depth].reset(tinfo);
+    ThreadProfile::bump(ts.frames_reused);
+  } else {
+    ts.stack.emplace_back(tinfo);
+  }
+  ts.stack[ts.depth].setMode(mode);
+  ts.depth++;
+  ts.profile.depth(ts.depth);
+  ThreadProfile::bump(ts.frames_pushed);
+  if (mode == FrameMode::Fingerprint) {
+    ThreadProfile::bump(ts.frames_fingerprinted);
+  }
+  debug_sanitizer(
+    "push: tinfo={} : level={}\n", names_.getName(tinfo), ts.depth
+  );
+}
+
+void Sanitizer::popImpl(ThreadState& ts, NameIDType tinfo) {
+  debug_sanitizer(
+    "pop: tinfo={} : level={}\n", names_.getName(tinfo), ts.depth
+  );
 
-  assert(stack_.back().getName() == tinfo && "Unmatched pop of stack");
+  assert(
+    ts.depth > 0 and ts.stack[ts.depth - 1].getName() == tinfo &&
+    "Unmatched pop of stack"
+  );
 
   // before we pop check the validity of this stack frame.
-  checkValidityFrame();
+  auto const missing = checkValidityFrame(ts);
 
-  stack_.pop_back();
+  if (sample_.stop_after > 0 or cache_.enabled()) {
+    updateTypeState(ts.stack[ts.depth - 1], missing);
+  }
+
+  ts.depth--;
 }
 
-void Sanitizer::checkValidityFrame() {
-  debug_sanitizer("checkValidityFrame: size={}\n", stack_.size());
+void Sanitizer::popUnchecked(ThreadState& ts) {
+  auto const& frame = ts.stack[ts.depth - 1];
+  if (frame.getMode() == FrameMode::Fingerprint) {
+    auto& type = types_.get(frame.getName());
+    if (frame.getFingerprint() != type.signature.load(std::memory_order_relaxed)) {
+      // the layout changed (e.g., conditional serialization): escalate the
+      // type back to full checking, and check this object in full since it
+      // is the one that may be missing members; a clean object starts
+      // proving its layout
+      type.proven.store(false, std::memory_order_relaxed);
+      type.stable.store(0, std::memory_order_relaxed);
+      type.escalations.fetch_add(1, std::memory_order_relaxed);
+      replayDeferred(ts);
+      updateTypeState(frame, checkValidityFrame(ts));
+    }
+  }
+  ts.depth--;
+}
 
-  assert(stack_.size() > 0 && "Must have a valid live stack");
-  auto& e = stack_.back();
+void Sanitizer::replayDeferred(ThreadState& ts) {
+  auto& frame = ts.stack[ts.depth - 1];
+  auto id = [&](StaticName const& name, NameIDType name_id) {
+    return name.str != nullptr ? intern(ts, name) : name_id;
+  };
 
-  auto const& checked = e.getCheck();
-  auto const& ignored = e.getIgnored();
-  auto const& is_serialized = e.getIsSerial();
+  frame.setMode(FrameMode::Check);
+  frame.clearFingerprint();
+  for (auto&& h : frame.getDeferred()) {
+    if (h.layout != nullptr) {
+      checkLayoutImpl(ts, h.addr, h.layout, h.count);
+    } else if (h.bit == Checked) {
+      frame.checkElm(h.addr, id(h.name, h.name_id), id(h.tinfo, h.tinfo_id));
+    } else if (h.bit == Ignored) {
+      frame.ignoreElm(h.addr, id(h.name, h.name_id), id(h.tinfo, h.tinfo_id));
+    } else {
+      frame.isSerialized(h.addr, h.bytes, id(h.tinfo, h.tinfo_id));
+    }
+  }
+}
 
-  for (auto&& elm : checked) {
-    // Skip check for elements that are explicitly skipped/ignored by the user
-    auto ignore_iter = ignored.find(elm);
-    if (ignore_iter != ignored.end()) {
-      continue;
+void Sanitizer::updateTypeState(StackRecord const& frame, std::size_t missing) {
+  auto& type = types_.get(frame.getName());
+
+  // retire a type from checking once it has validated cleanly enough times
+  if (sample_.stop_after > 0) {
+    if (missing > 0) {
+      type.clean.store(0, std::memory_order_relaxed);
+    } else if (type.clean.fetch_add(1) + 1 >= sample_.stop_after) {
+      type.retired.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  // prove a type once enough clean validations share the same fingerprint
+  if (cache_.enabled()) {
+    if (missing > 0) {
+      type.stable.store(0, std::memory_order_relaxed);
+    } else {
+      auto const sig = frame.getFingerprint();
+      if (sig != type.signature.load(std::memory_order_relaxed)) {
+        type.signature.store(sig, std::memory_order_relaxed);
+        type.stable.store(1, std::memory_order_relaxed);
+      } else if (type.stable.fetch_add(1) + 1 >= cache_.after) {
+        type.proven.store(true, std::memory_order_relaxed);
+      }
     }
+  }
+}
+
+std::size_t Sanitizer::checkValidityFrame(ThreadState& ts) {
+  debug_sanitizer("checkValidityFrame: size={}\n", ts.depth);
 
-    auto ser_iter = is_serialized.find(elm);
-    if (ser_iter == is_serialized.end()) {
+  assert(ts.depth > 0 && "Must have a valid live stack");
+  auto& e = ts.stack[ts.depth - 1];
+  std::size_t missing = 0;
+
+  // one sweep over the frame: checked, but neither ignored nor serialized
+  for (auto&& elm : e.getEntries()) {
+    if (elm.isMissing() and not e.inSerializedRange(elm.addr)) {
       debug_sanitizer(
         "**missing: name={}, tinfo={}, addr={} : level={}\n",
-        elm.name, elm.tinfo, elm.addr, stack_.size()
+        names_.getName(elm.name), names_.getName(elm.tinfo), elm.addr,
+        ts.depth
       );
 
       // we are missing a element in the serializer
-      std::vector<std::string> stack;
-      for (auto i = stack_.rbegin(); i != stack_.rend(); i++) {
-        stack.push_back(i->getName());
+      if (log_ != nullptr) {
+        log_->missing(elm.name, elm.tinfo, resolveStackNode(ts));
+      } else {
+        missing_.add(elm.name, elm.tinfo, resolveStackNode(ts));
       }
+      missing++;
+    }
+  }
 
-      auto missing_iter = missing_.find(elm.name);
-      if (missing_iter == missing_.end()) {
-        missing_.emplace(
-          std::piecewise_construct,
-          std::forward_as_tuple(elm.name),
-          std::forward_as_tuple(
-            std::make_unique<MissingInfo>(elm.name, elm.tinfo, stack)
-          )
+  // members of a layout table: checked, but their bit was never set and none
+  // of their bytes serialized, or only some of their bytes serialized
+  if (e.hasLayout()) {
+    missing += e.validateLayout(
+      [&](MemberLayout const& m) {
+        debug_sanitizer(
+          "**missing: name={}, tinfo={}, offset={} : level={}\n",
+          m.name.str, m.tinfo.str, m.offset, ts.depth
         );
-      } else {
-        missing_iter->second->addStack(stack);
+        auto const name = intern(ts, m.name);
+        auto const tinfo = intern(ts, m.tinfo);
+        if (log_ != nullptr) {
+          log_->missing(name, tinfo, resolveStackNode(ts));
+        } else {
+          missing_.add(name, tinfo, resolveStackNode(ts));
+        }
+      },
+      [&](MemberLayout const& m, std::size_t bytes) {
+        debug_sanitizer(
+          "**partial: name={}, tinfo={}, offset={}, bytes={}/{} : level={}\n",
+          m.name.str, m.tinfo.str, m.offset, bytes, m.data_size, ts.depth
+        );
+        auto const name = intern(ts, m.name);
+        auto const tinfo = intern(ts, m.tinfo);
+        if (log_ != nullptr) {
+          log_->partial(name, tinfo, resolveStackNode(ts), bytes, m.data_size);
+        } else {
+          partial_.addPartial(
+            name, tinfo, resolveStackNode(ts), bytes, m.data_size
+          );
+        }
       }
-    }
+    );
   }
+  return missing;
 }
 
-static std::string demangle(char const* name) {
-  int status = 0;
+StackNodeIDType Sanitizer::resolveStackNode(ThreadState& ts) {
+  // Resolved frames always form a prefix of the live stack: find the first
+  // unresolved frame and extend the trie path from its parent downwards. Each
+  // frame is resolved at most once while it is live.
+  std::size_t first = ts.depth;
+  while (first > 0 and not ts.stack[first - 1].hasNode()) {
+    first--;
+  }
+  auto node = first == 0 ? root_stack_node : ts.stack[first - 1].getNode();
+  for (auto i = first; i < ts.depth; i++) {
+    node = stacks_.child(node, ts.stack[i].getName());
+    ts.stack[i].setNode(node);
+  }
+  return node;
+}
 
-  std::unique_ptr<char, void(*)(void*)> res {
-    abi::__cxa_demangle(name, NULL, NULL, &status),
-    std::free
+void Sanitizer::buildReport(Report& report) {
+  report.pids.push_back(static_cast<uint32_t>(getpid()));
+  auto const sum = totals();
+  report.frames_pushed += sum.frames_pushed;
+  report.frames_reused += sum.frames_reused;
+
+  // map interned names and trie nodes to report indices on first use
+  std::unordered_map<NameIDType, uint32_t> strings;
+  std::unordered_map<StackNodeIDType, uint32_t> nodes;
+  auto str = [&](NameIDType id) {
+    auto iter = strings.find(id);
+    if (iter == strings.end()) {
+      iter = strings.emplace(id, report.addString(names_.getName(id))).first;
+    }
+    return iter->second;
   };
-
-  return status == 0 ? res.get() : name;
+  auto node = [&](StackNodeIDType id) {
+    auto const stack = stacks_.getStack(id);
+    auto n = report_root_node;
+    for (auto iter = stack.rbegin(); iter != stack.rend(); ++iter) {
+      n = report.addNode(n, str(*iter));
+    }
+    return n;
+  };
+  auto collect = [&](std::vector<MissingInfo> const& infos, bool partial) {
+    for (auto&& e : infos) {
+      bool first = true;
+      for (auto&& st : e.getStacks()) {
+        auto niter = nodes.find(st.first);
+        if (niter == nodes.end()) {
+          niter = nodes.emplace(st.first, node(st.first)).first;
+        }
+        report.add(
+          str(e.getName()), str(e.getTinfo()), partial, niter->second, st.second,
+          first ? e.getCoveredBytes() : 0, first ? e.getTotalBytes() : 0
+        );
+        first = false;
+      }
+    }
+  };
+  collect(missing_.snapshot(), false);
+  collect(partial_.snapshot(), true);
 }
 
-inline bool colorizeOutput() {
-  return output_colorize;
+void Sanitizer::reduceAcrossRanks(RankTransport& transport) {
+  // every rank reads the same environment, so all of them take this branch
+  if (log_ != nullptr or not ReportConfig::fromEnv().reduce) {
+    return;
+  }
+
+  Report report;
+  buildReport(report);
+  report.setRank(static_cast<uint32_t>(transport.rank()));
+  if (reduceReport(report, transport)) {
+    writeReport(report);
+  }
+  reduced_ = true;
 }
 
-inline std::string green()    { return colorizeOutput() ? "\033[32m"   : ""; }
-inline std::string bold()     { return colorizeOutput() ? "\033[1m"    : ""; }
-inline std::string magenta()  { return colorizeOutput() ? "\033[95m"   : ""; }
-inline std::string red()      { return colorizeOutput() ? "\033[31m"   : ""; }
-inline std::string bred()     { return colorizeOutput() ? "\033[31;1m" : ""; }
-inline std::string reset()    { return colorizeOutput() ? "\033[00m"   : ""; }
-inline std::string bd_green() { return colorizeOutput() ? "\033[32;1m" : ""; }
-inline std::string it_green() { return colorizeOutput() ? "\033[32;3m" : ""; }
-inline std::string un_green() { return colorizeOutput() ? "\033[32;4m" : ""; }
-inline std::string byellow()  { return colorizeOutput() ? "\033[33;1m" : ""; }
-inline std::string yellow()   { return colorizeOutput() ? "\033[33m"   : ""; }
-inline std::string blue()     { return colorizeOutput() ? "\033[34m"   : ""; }
+void Sanitizer::printSummary() {
+  if (reduced_) {
+    return;
+  }
 
-inline std::string emph(std::string str) {
-  return magenta() + str + reset();
-}
-inline std::string reg(std::string str) {
-  return green() + str + reset();
-}
-inline std::string vtPre() {
-  return bd_green() + std::string("vt:sanitizer") + reset() + ": ";
-}
-inline std::string proc(pid_t pid)  {
-  return blue() + "" + std::to_string(pid) + ":" + reset();
+  Report report;
+  buildReport(report);
+  report.setRank(0);
+  writeReport(report);
 }
 
-template <typename... Args>
-static void outputPidLines(
-  FILE* fd, pid_t pid, std::string const& line, Args&&... args
-) {
-  auto s = fmt::format(proc(pid) + vtPre() + line, std::forward<Args>(args)...);
-  fmt::print(fd, s);
-}
+void Sanitizer::writeReport(Report const& report) {
+  auto const sum = totals();
+  auto const frames_skipped = sum.frames_skipped;
+  auto const frames_fingerprinted = sum.frames_fingerprinted;
+  auto const disabled = serializations_disabled_.load(std::memory_order_relaxed);
 
-void Sanitizer::printSummary() {
-  std::vector<MissingInfo*> m;
-  for (auto&& e : missing_) {
-    m.push_back(e.second.get());
+  auto pid = getpid();
+  if (ReportConfig::fromEnv().binary) {
+    auto const path = fmt::format("{}.sanitize.report", pid);
+    std::string buf;
+    report.serialize(buf);
+    auto out = fopen(path.c_str(), "wb");
+    if (out == nullptr or fwrite(buf.data(), 1, buf.size(), out) != buf.size()) {
+      perror("Error writing sanitizer report: ");
+    } else {
+      fmt::print("Sanitizer: wrote report to {}\n", path);
+    }
+    if (out != nullptr) {
+      fclose(out);
+    }
+    return;
   }
-  std::sort(m.begin(), m.end(), [](MissingInfo* m1, MissingInfo* m2) -> bool {
-    return m1->getInstances() > m2->getInstances();
-  });
+
   FILE* fd = stdout;
   std::string pid_str = "";
-  auto pid = getpid();
   if (output_as_file) {
     pid_str = fmt::format("{}.sanitize.out", pid);
     auto nfd = fopen(pid_str.c_str(), "a");
@@ -217,58 +814,104 @@ void Sanitizer::printSummary() {
     }
   }
 
-  outputPidLines(
-    fd, pid,
-    yellow() +  "===========================================\n" + reset()
-  );
-  outputPidLines(
-    fd, pid,
-    yellow() + "===== " +
-    green() + "Serialization Sanitizer Output" +
-    yellow() + " ======\n" +
-    reset()
-  );
-  outputPidLines(
-    fd, pid,
-    yellow() + "===========================================\n" + reset()
+  SummaryPrinter out{fd, pid, output_colorize};
+  out.banner();
+  if (report.pids.size() > 1) {
+    out.line("---- reduced from {} ranks ----\n", report.pids.size());
+  }
+  out.line(
+    "---- frames pushed: {}, reused from pool: {} ----\n",
+    report.frames_pushed, report.frames_reused
   );
-
-  for (auto&& e : m) {
-    auto const& name = e->getName();
-    auto const& tinfo = e->getTinfo();
-    auto const& stacks = e->getStacks();
-    auto const& insts = e->getInstances();
-
-    outputPidLines(fd, pid, "---- Found missing serialized member ----\n");
-    outputPidLines(fd, pid, "-----------------------------------------\n");
-    outputPidLines(
-      fd, pid, "---- {}{}{} -- {}{} instances{} ----\n",
-      bred(), name, reset(), bold(), insts, reset()
+  // sampling and cache statistics are only known for the local process
+  bool const local = report.pids.size() == 1;
+  if (local and disabled > 0) {
+    out.line(
+      "---- sanitization off: {} serializations not checked ----\n", disabled
     );
-    outputPidLines(
-      fd, pid, "---- {}type: {}{} ---- \n", magenta(), tinfo, reset()
+  }
+  if (local and sample_.enabled()) {
+    std::size_t retired = 0;
+    types_.forEach([&](NameIDType, TypeState const& type) {
+      retired += type.retired.load() ? 1 : 0;
+    });
+    out.line(
+      "---- sampling: {} objects checked, {} skipped, {} types retired ----\n",
+      report.frames_pushed, frames_skipped,
+      retired
+    );
+  }
+  if (local and cache_.enabled()) {
+    std::size_t proven = 0;
+    uint64_t escalations = 0;
+    types_.forEach([&](NameIDType, TypeState const& type) {
+      proven += type.proven.load() ? 1 : 0;
+      escalations += type.escalations.load();
+    });
+    out.line(
+      "---- validation cache: {} types proven, {} objects fingerprinted, "
+      "{} escalations ----\n",
+      proven, frames_fingerprinted, escalations
+    );
+  }
+  if (log_ != nullptr) {
+    out.line(
+      "---- missing members streamed to {} (render with sanitizer-report) ----\n",
+      log_->getPath()
     );
-    for (std::size_t i = 0; i < stacks.size(); i++) {
-      auto const& cs = stacks.at(i);
-      auto const& stack = cs.getStack();
-      auto const& sinsts = cs.getInstances();
-      outputPidLines(
-        fd, pid, "---- {}stack {}{}, {}{} instances{} \n",
-        bd_green(), i, reset(), bold(), sinsts, reset()
-      );
-      for (std::size_t j = 0; j < stack.size(); j++) {
-        outputPidLines(
-          fd, pid, "\t {}{}{}\n", red(), demangle(stack.at(j).c_str()), reset()
-        );
-      }
-    };
-    outputPidLines(fd, pid, "----------------------------------------\n");
   }
 
+  for (auto&& member : report.toSummary()) {
+    out.member(member);
+  }
+  out.flush();
+
   if (fd != stdout) {
     fmt::print("Sanitizer: wrote output to {}\n", pid_str);
     fclose(fd);
   }
 }
 
+void Sanitizer::printProfile() {
+  auto const sum = totals();
+  auto const now = profileNow();
+  auto const& calls = sum.calls;
+  auto const max_depth = sum.max_depth;
+  auto const checks = sum.checks;
+  auto const timed = sum.timed_calls;
+  auto const inside_ns = sum.inside_ns;
+  auto const thread_ns = sum.thread_ns;
+  auto const num_threads = sum.threads;
+
+  auto const pushed = calls[static_cast<std::size_t>(HookKind::Push)];
+  auto const ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+
+  SummaryPrinter out{stderr, getpid(), output_colorize};
+  out.line(
+    "---- profile: {} threads, {:.3f} ms since start ----\n",
+    num_threads, ms(now - start_ns_)
+  );
+  for (std::size_t i = 0; i < num_hook_kinds; i++) {
+    out.line(
+      "  {:<14} {:>14} calls\n", hookKindName(static_cast<HookKind>(i)),
+      calls[i]
+    );
+  }
+  out.line(
+    "  frames pushed: {}, max depth: {}, checks per frame: {:.2f}\n",
+    pushed, max_depth,
+    pushed > 0 ? static_cast<double>(checks) / pushed : 0.0
+  );
+  if (profile_.period == 0 or timed == 0) {
+    out.line("  time in sanitizer: not measured\n");
+  } else {
+    out.line(
+      "  time in sanitizer: {:.3f} ms of {:.3f} ms thread time ({:.2f}%), "
+      "timed 1 in {} calls\n",
+      ms(inside_ns), ms(thread_ns),
+      thread_ns > 0 ? 100.0 * inside_ns / thread_ns : 0.0, profile_.period
+    );
+  }
+}
+
 }} /* end namespace checkpoint::sanitizer */
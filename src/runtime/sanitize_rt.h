@@ -49,26 +49,39 @@
 #include "runtime_interface.h"
 #include "stack_record.h"
 #include "missing_info.h"
+#include "name_table.h"
+#include "thread_state.h"
+#include "type_table.h"
+#include "type_sampler.h"
+#include "config.h"
+#include "event_log.h"
+#include "report.h"
+#include "rank_reduce.h"
+#include "profile.h"
+#include "control.h"
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <vector>
 #include <memory>
-#include <unordered_map>
 #include <string>
+#include <mutex>
 
 namespace checkpoint { namespace sanitizer {
 
+/**
+ * \struct Sanitizer
+ *
+ * \brief The sanitizer runtime. Hooks may be invoked concurrently from
+ * several threads: each thread serializes against its own \c ThreadState;
+ * the name table, call stacks and missing members are shared.
+ */
 struct Sanitizer : Runtime {
 
-  Sanitizer() {
-    debug_sanitizer("Constructing sanitizer runtime\n");
-  }
+  Sanitizer();
 
-  virtual ~Sanitizer() {
-    debug_sanitizer("Destroying sanitizer runtime\n");
-    printSummary();
-  }
+  virtual ~Sanitizer();
 
   void checkMember(void* addr, std::string name, std::string tinfo) override;
   void skipMember(void* addr, std::string name, std::string tinfo) override;
@@ -76,26 +89,210 @@ struct Sanitizer : Runtime {
   void push(std::string tinfo) override;
   void pop(std::string tinfo) override;
 
+  void checkMember(void* addr, StaticName name, StaticName tinfo) override;
+  void skipMember(void* addr, StaticName name, StaticName tinfo) override;
+  void isSerialized(void* addr, std::size_t num, StaticName tinfo) override;
+  void isSerialized(
+    void* addr, std::size_t num, std::size_t size, StaticName tinfo
+  ) override;
+  void push(StaticName tinfo) override;
+  void pop(StaticName tinfo) override;
+
+  void checkLayout(
+    void* base, MemberLayout const* layout, std::size_t count
+  ) override;
+
+  /**
+   * \brief Reduce the reports of all ranks to rank 0, which writes the one
+   * report of the job; the other ranks write nothing at shutdown. Must be
+   * called by every rank.
+   *
+   * \param[in] transport the transport between the ranks
+   */
+  void reduceAcrossRanks(RankTransport& transport);
+
+  /**
+   * \brief Print the self-profile of the runtime to stderr: the hook calls
+   * by kind, frames pushed and the deepest stack, checks per frame and the
+   * time spent in hooks. Safe to call while other threads invoke hooks.
+   */
+  void printProfile();
+
 protected:
+  /**
+   * \internal \brief Get the state of the calling thread, creating it on
+   * the first hook invoked by the thread
+   *
+   * \return the thread's state
+   */
+  ThreadState& local();
+
+  /**
+   * \internal \brief Enter an object on the calling thread. The outermost
+   * object of a serialization reads whether sanitization is on, then the
+   * object is sampled. The hooks of an object that is not sanitized or
+   * sampled out, and of every object nested in it, return before touching
+   * any state.
+   *
+   * \param[in] tinfo the name of the type of the object
+   * \param[in] hash the hash of the name, when sampling is enabled
+   *
+   * \return whether the object is not sanitized
+   */
+  bool enterObject(char const* tinfo, uint64_t hash);
+
+  /**
+   * \internal \brief Sum the counters of the threads that have exited and of
+   * the threads still running
+   *
+   * \return the totals
+   */
+  ThreadTotals totals();
+
+  NameIDType intern(ThreadState& ts, StaticName const& name);
+  NameIDType intern(ThreadState& ts, std::string const& name);
+
+  void checkMemberImpl(
+    ThreadState& ts, void* addr, NameIDType name, NameIDType tinfo
+  );
+  void skipMemberImpl(
+    ThreadState& ts, void* addr, NameIDType name, NameIDType tinfo
+  );
+  void isSerializedImpl(
+    ThreadState& ts, void* addr, std::size_t num, std::size_t size,
+    NameIDType tinfo
+  );
+  void checkLayoutImpl(
+    ThreadState& ts, void* base, MemberLayout const* layout, std::size_t count
+  );
+  void pushImpl(ThreadState& ts, NameIDType tinfo);
+  void popImpl(ThreadState& ts, NameIDType tinfo);
+
+  /**
+   * \internal \brief Decide whether an object being pushed is checked
+   * according to the sampling configuration
+   *
+   * \param[in] tinfo the name of the type of the object
+   * \param[in] hash the hash of the name
+   *
+   * \return whether the object is checked
+   */
+  bool sampleObject(char const* tinfo, uint64_t hash);
+
+  /**
+   * \internal \brief Pop a frame that was only fingerprinted. A
+   * fingerprint that differs from the proven one sends the type back to full
+   * checking.
+   *
+   * \param[in] ts the state of the popping thread
+   */
+  void popUnchecked(ThreadState& ts);
+
+  /**
+   * \internal \brief Replay the hooks kept by a fingerprinted frame into its
+   * frame table, turning it into a checked frame
+   *
+   * \param[in] ts the state of the thread owning the innermost frame
+   */
+  void replayDeferred(ThreadState& ts);
+
+  /**
+   * \internal \brief Update the per-type state after a frame was checked
+   *
+   * \param[in] frame the checked frame
+   * \param[in] missing the number of missing members found in the frame
+   */
+  void updateTypeState(StackRecord const& frame, std::size_t missing);
+
   /**
    * \internal \brief Check the validity of the current stack frame.x
    *
+   * \param[in] ts the state of the thread popping the frame
+   *
    * \note Called right before a stack frame is popped
+   *
+   * \return the number of missing members found in the frame
+   */
+  std::size_t checkValidityFrame(ThreadState& ts);
+
+  /**
+   * \internal \brief Resolve the call-stack trie node of the innermost live
+   * frame, resolving any enclosing frames that are not resolved yet
+   *
+   * \param[in] ts the state of the thread
+   *
+   * \return the trie node identifying the live stack
+   */
+  StackNodeIDType resolveStackNode(ThreadState& ts);
+
+  /**
+   * \internal \brief Build the report of the missing members recorded so far
+   *
+   * \param[out] report the report
    */
-  void checkValidityFrame();
+  void buildReport(Report& report);
 
   /**
-   * \internal \brief Print a summary of missing members during serialization
+   * \internal \brief Print a summary of missing members during serialization,
+   * or write the binary report, unless the report was reduced across ranks
    *
    * \note Called at shutdown
    */
   void printSummary();
 
+  /**
+   * \internal \brief Print a report as the text summary or write it as a
+   * binary report, according to the configuration
+   *
+   * \param[in] report the report
+   */
+  void writeReport(Report const& report);
+
 private:
-  /// Current stack for sanitizer
-  std::vector<StackRecord> stack_;
-  /// Set of missing members that the sanitizer caught
-  std::unordered_map<std::string, std::unique_ptr<MissingInfo>> missing_;
+  /**
+   * \internal \brief Fold the counters of a thread's state into the totals
+   * of exited threads and free the state, when the runtime that owns it is
+   * still alive
+   *
+   * \param[in] instance the identifier of the owning runtime
+   * \param[in] state the thread's state
+   */
+  static void retireThread(uint64_t instance, ThreadState* state);
+
+  /// Unique identifier of this runtime instance for thread-local lookup
+  uint64_t instance_ = 0;
+  /// Sampling configuration read from the environment
+  SampleConfig sample_;
+  /// Validation cache configuration read from the environment
+  CacheConfig cache_;
+  /// Self-profile configuration read from the environment
+  ProfileConfig profile_;
+  /// When the runtime was constructed
+  uint64_t start_ns_ = 0;
+  /// Interned member and type names
+  NameTable names_;
+  /// Per-type state, indexed by the interned type ID
+  TypeTable types_;
+  /// Protects \c threads_ and \c retired_
+  std::mutex threads_mutex_;
+  /// State of every running thread that has invoked a hook
+  std::vector<std::unique_ptr<ThreadState>> threads_;
+  /// Counters of the threads that have exited
+  ThreadTotals retired_;
+  /// Number of serializations not checked because sanitization was off
+  std::atomic<uint64_t> serializations_disabled_{0};
+  /// Prefix trie of the call stacks missing members were reached through
+  CallStackTrie stacks_;
+  /// Missing members that the sanitizer caught
+  MissingRegistry missing_;
+  /// Members of layout tables that were only partially serialized
+  MissingRegistry partial_;
+  /// Streaming log of missing members, replacing the registries when enabled
+  std::unique_ptr<EventLog> log_;
+  /// Whether the report was reduced across ranks and written by rank 0
+  bool reduced_ = false;
+  /// Prints the profile when the profile signal is delivered
+  ProfileSignal profile_signal_;
 };
 
 extern bool output_as_file;
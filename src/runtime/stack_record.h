@@ -45,91 +45,480 @@
 #if !defined INCLUDED_SANITIZER_RUNTIME_STACK_RECORD_H
 #define INCLUDED_SANITIZER_RUNTIME_STACK_RECORD_H
 
-#include <unordered_set>
-#include <string>
-#include <tuple>
+#include "runtime_interface.h"
+#include "call_stack_trie.h"
+#include "interval_set.h"
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
 
 namespace checkpoint { namespace sanitizer {
 
-struct PtrName {
+/// State bits tracked for each address in a stack frame
+enum FrameStateBits : uint8_t {
+  Checked    = 0x1,
+  Ignored    = 0x2,
+  Serialized = 0x4
+};
+
+/// How the hooks invoked in a stack frame are handled
+enum struct FrameMode : uint8_t {
+  /// Record every address in the frame table and validate on pop
+  Check,
+  /// Type layout already proven: only accumulate the offset fingerprint
+  Fingerprint
+};
+
+/**
+ * \brief Mix the offset of an address relative to the first address seen in
+ * a frame with a state bit and the bytes serialized in bulk from it;
+ * fingerprints are order-independent sums of these
+ *
+ * \param[in] offset the relative offset
+ * \param[in] bit the state bit
+ * \param[in] bytes the number of bytes serialized in bulk, 0 when unknown
+ *
+ * \return the mixed value
+ */
+inline uint64_t mixOffset(uint64_t offset, uint8_t bit, uint64_t bytes = 0) {
+  uint64_t h = (offset << 3 | bit) + 0x9E3779B97F4A7C15ull +
+    bytes * 0xC2B2AE3D27D4EB4Full;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+  return h ^ (h >> 31);
+}
+
+/**
+ * \struct FrameEntry
+ *
+ * \brief An address seen in a stack frame with the state bits accumulated
+ * from the hooks and the interned name/type of the member (when checked)
+ */
+struct FrameEntry {
 
-  PtrName(void* in_addr, std::string const& in_name)
+  FrameEntry(void* in_addr, NameIDType in_name, NameIDType in_tinfo)
     : addr(in_addr),
-      name(in_name)
+      name(in_name),
+      tinfo(in_tinfo)
   { }
 
-  void* addr = nullptr;
-  std::string name = "";
-
-  friend bool operator==(PtrName const& a, PtrName const& b) {
-    return a.addr == b.addr;
+  bool isMissing() const {
+    return (state & Checked) and not (state & (Ignored | Serialized));
   }
+
+  void* addr = nullptr;
+  NameIDType name = no_name_id;
+  NameIDType tinfo = no_name_id;
+  uint8_t state = 0;
 };
 
-struct PtrNameType : PtrName {
+/**
+ * \struct DeferredHook
+ *
+ * \brief A hook invoked in a frame in \c FrameMode::Fingerprint, kept so
+ * the object can still be checked in full when its fingerprint turns out not
+ * to match the one proven for its type. Names are kept static and interned
+ * only if the hook is replayed; hooks with dynamic names carry interned IDs.
+ */
+struct DeferredHook {
 
-  PtrNameType(
-    void* in_addr, std::string const& in_name, std::string const& in_tinfo
-  ) : PtrName(in_addr, in_name),
+  DeferredHook(void* in_addr, uint8_t in_bit, StaticName in_name, StaticName in_tinfo)
+    : addr(in_addr),
+      bit(in_bit),
+      name(in_name),
       tinfo(in_tinfo)
   { }
 
-  std::string tinfo = "";
+  DeferredHook(void* in_addr, uint8_t in_bit, NameIDType in_name, NameIDType in_tinfo)
+    : addr(in_addr),
+      bit(in_bit),
+      name_id(in_name),
+      tinfo_id(in_tinfo)
+  { }
 
-  friend bool operator==(PtrNameType const& a, PtrNameType const& b) {
-    return static_cast<PtrName>(a) == static_cast<PtrName>(b);
-  }
+  DeferredHook(void* in_base, MemberLayout const* in_layout, std::size_t in_count)
+    : addr(in_base),
+      bit(Checked),
+      layout(in_layout),
+      count(in_count)
+  { }
+
+  void* addr = nullptr;
+  uint8_t bit = 0;
+  /// The bytes serialized, for a \c Serialized hook
+  std::size_t bytes = 0;
+  /// The static names, or null when the interned IDs are set instead
+  StaticName name{nullptr, 0};
+  StaticName tinfo{nullptr, 0};
+  NameIDType name_id = no_name_id;
+  NameIDType tinfo_id = no_name_id;
+  /// The layout table, for a \c checkLayout hook
+  MemberLayout const* layout = nullptr;
+  std::size_t count = 0;
 };
 
-}} /* end namespace checkpoint::sanitizer */
+/**
+ * \struct StackRecord
+ *
+ * \brief A stack frame of the sanitizer. Every address is stored once in a
+ * dense, insertion-ordered vector of entries. Small frames are searched
+ * linearly; once a frame grows past \c linear_limit entries an
+ * open-addressing index of entry positions keyed by address is built.
+ */
+struct StackRecord {
+  explicit StackRecord(NameIDType in_name)
+    : name_(in_name)
+  { }
 
-namespace std {
+  /**
+   * \brief Clear the frame for reuse by another push, retaining capacity
+   *
+   * \param[in] in_name the type of the new frame
+   */
+  void reset(NameIDType in_name) {
+    name_ = in_name;
+    node_ = unresolved_stack_node;
+    mode_ = FrameMode::Check;
+    base_ = nullptr;
+    fingerprint_ = 0;
+    entries_.clear();
+    index_.clear();
+    object_ = nullptr;
+    layout_ = nullptr;
+    layout_count_ = 0;
+    covered_.clear();
+    ranges_.clear();
+    deferred_.clear();
+  }
 
-template <>
-struct hash<checkpoint::sanitizer::PtrName> {
-  std::size_t operator()(checkpoint::sanitizer::PtrName const& p) const {
-    return std::hash<intptr_t>{}(reinterpret_cast<intptr_t>(p.addr));
+  /**
+   * \brief Record a serialized address; a non-zero byte count also records
+   * the range it covers, so members inside a bulk-serialized block count as
+   * serialized without one call each
+   *
+   * \param[in] addr the address serialized
+   * \param[in] bytes the number of bytes serialized, 0 when unknown
+   * \param[in] tinfo the type serialized
+   */
+  void isSerialized(void* addr, std::size_t bytes, NameIDType tinfo) {
+    if (not coverLayout(addr)) {
+      findOrInsert(addr, no_name_id, tinfo).state |= Serialized;
+    }
+    if (bytes > 0) {
+      auto const begin = reinterpret_cast<uintptr_t>(addr);
+      ranges_.insert(begin, begin + bytes);
+    }
+    fingerprint(addr, Serialized, bytes);
   }
-};
 
-template <>
-struct hash<checkpoint::sanitizer::PtrNameType> {
-  std::size_t operator()(checkpoint::sanitizer::PtrNameType const& p) const {
-    return std::hash<checkpoint::sanitizer::PtrName>{}(p);
+  /**
+   * \brief Whether an address falls in a range serialized in bulk
+   *
+   * \param[in] addr the address
+   */
+  bool inSerializedRange(void* addr) const {
+    return not ranges_.empty() and
+      ranges_.contains(reinterpret_cast<uintptr_t>(addr));
   }
-};
 
-} /* end namespace std */
+  void checkElm(void* addr, NameIDType name, NameIDType tinfo) {
+    findOrInsert(addr, name, tinfo).state |= Checked;
+    fingerprint(addr, Checked);
+  }
 
-namespace checkpoint { namespace sanitizer {
+  void ignoreElm(void* addr, NameIDType name, NameIDType tinfo) {
+    if (not coverLayout(addr)) {
+      findOrInsert(addr, name, tinfo).state |= Ignored;
+    }
+    fingerprint(addr, Ignored);
+  }
 
-struct StackRecord {
-  explicit StackRecord(std::string const& in_name)
-    : name_(in_name)
-  { }
+  /**
+   * \brief Check every member of a generated layout table. The members are
+   * tracked by their index in the table in a bitset instead of the frame
+   * table; addresses already serialized or ignored in the frame are carried
+   * over into the bitset.
+   *
+   * \param[in] object the address of the object
+   * \param[in] layout the layout table of the object's class
+   * \param[in] count the number of entries in the table
+   *
+   * \return whether the layout was taken; otherwise (a layout is already
+   * set, or the offsets are not ascending) the members must be checked one
+   * by one
+   */
+  bool setLayout(void* object, MemberLayout const* layout, std::size_t count) {
+    if (layout_ != nullptr) {
+      return false;
+    }
+    for (std::size_t i = 1; i < count; i++) {
+      if (layout[i].offset < layout[i - 1].offset) {
+        return false;
+      }
+    }
 
-  void isSerialized(void* addr, std::string name) {
-    is_serialized_.emplace(PtrName{addr, name});
+    object_ = object;
+    layout_ = layout;
+    layout_count_ = count;
+    covered_.assign((count + word_bits - 1) / word_bits, 0);
+    for (auto&& e : entries_) {
+      if (e.state & (Ignored | Serialized)) {
+        coverLayout(e.addr);
+      }
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      fingerprint(static_cast<char*>(object) + layout[i].offset, Checked);
+    }
+    return true;
   }
 
-  void checkElm(void* addr, std::string const& name, std::string const& tinfo) {
-    check_.emplace(PtrNameType{addr, name, tinfo});
+  /**
+   * \brief Whether the members of a layout table are tracked in the bitset
+   */
+  bool hasLayout() const { return layout_ != nullptr; }
+
+  /**
+   * \brief Validate the members of the layout table. A member is missing
+   * when it was neither serialized nor ignored and none of its bytes fall in
+   * a range serialized in bulk. A member is partially serialized when some,
+   * but fewer than \c data_size, of its bytes fall in serialized ranges.
+   *
+   * \param[in] missing_fn called with the layout entry of a missing member
+   * \param[in] partial_fn called with the layout entry of a partially
+   * serialized member and the number of its bytes serialized
+   *
+   * \return the number of missing and partially serialized members
+   */
+  template <typename MissingFn, typename PartialFn>
+  std::size_t validateLayout(MissingFn&& missing_fn, PartialFn&& partial_fn) const {
+    std::size_t const words = covered_.size();
+    std::size_t found = 0;
+
+    if (ranges_.empty()) {
+      // fast path: a word-wise AND/NOT over the bitset finds a clean frame
+      // without visiting members
+      uint64_t any = 0;
+      for (std::size_t w = 0; w < words; w++) {
+        any |= ~covered_[w] & wordMask(w);
+      }
+      if (any == 0) {
+        return 0;
+      }
+
+      for (std::size_t w = 0; w < words; w++) {
+        for (auto bits = ~covered_[w] & wordMask(w); bits != 0; bits &= bits - 1) {
+          missing_fn(layout_[w * word_bits + __builtin_ctzll(bits)]);
+          found++;
+        }
+      }
+      return found;
+    }
+
+    // one sweep over the members and the serialized ranges, both ascending
+    auto const object = reinterpret_cast<uintptr_t>(object_);
+    ranges_.sweep(
+      layout_count_,
+      [&](std::size_t i) {
+        auto const begin = object + layout_[i].offset;
+        return Interval{begin, begin + layout_[i].size};
+      },
+      [&](std::size_t i, std::size_t bytes) {
+        auto const& m = layout_[i];
+        auto const bit = covered_[i / word_bits] & (uint64_t{1} << (i % word_bits));
+        if (bytes == 0 and bit == 0) {
+          missing_fn(m);
+          found++;
+        } else if (bytes > 0 and bytes < m.data_size) {
+          partial_fn(m, bytes);
+          found++;
+        }
+      }
+    );
+    return found;
   }
 
-  void ignoreElm(void* addr, std::string const& name, std::string const& tinfo) {
-    ignored_.emplace(PtrNameType{addr, name, tinfo});
+  std::vector<FrameEntry> const& getEntries() const { return entries_; }
+  NameIDType getName() const { return name_; }
+
+  /**
+   * \brief The call-stack trie node of this frame, resolved lazily when a
+   * missing member is first reported through it
+   */
+  StackNodeIDType getNode() const { return node_; }
+  void setNode(StackNodeIDType node) { node_ = node; }
+  bool hasNode() const { return node_ != unresolved_stack_node; }
+
+  FrameMode getMode() const { return mode_; }
+  void setMode(FrameMode mode) { mode_ = mode; }
+
+  /**
+   * \brief Accumulate a hook into the offset fingerprint. Checked frames
+   * accumulate it alongside their table; it is the only work done for a frame
+   * in \c FrameMode::Fingerprint
+   *
+   * \param[in] addr the address passed to the hook
+   * \param[in] bit the state bit for the hook
+   * \param[in] bytes the number of bytes serialized in bulk, 0 when unknown
+   */
+  void fingerprint(void* addr, uint8_t bit, std::size_t bytes = 0) {
+    if (base_ == nullptr) {
+      base_ = addr;
+    }
+    fingerprint_ += mixOffset(offsetOf(addr), bit, bytes);
   }
 
-  std::unordered_set<PtrNameType> const& getCheck() const { return check_; }
-  std::unordered_set<PtrNameType> const& getIgnored() const { return ignored_; }
-  std::unordered_set<PtrName> const& getIsSerial() const { return is_serialized_; }
-  std::string const& getName() const { return name_; }
+  /**
+   * \brief The offset fingerprint accumulated so far
+   */
+  uint64_t getFingerprint() const { return fingerprint_; }
+
+  /**
+   * \brief Drop the fingerprint accumulated so far, before the hooks that
+   * produced it are replayed into the frame and accumulate it again
+   */
+  void clearFingerprint() { fingerprint_ = 0; }
+
+  /**
+   * \brief Keep a hook invoked in \c FrameMode::Fingerprint for replay
+   *
+   * \param[in] hook the hook
+   */
+  void defer(DeferredHook const& hook) { deferred_.push_back(hook); }
+
+  /**
+   * \brief The hooks kept in \c FrameMode::Fingerprint, in invocation order
+   */
+  std::vector<DeferredHook> const& getDeferred() const { return deferred_; }
 
 private:
-  std::string name_ = "";
-  std::unordered_set<PtrNameType> check_;
-  std::unordered_set<PtrNameType> ignored_;
-  std::unordered_set<PtrName> is_serialized_;
+  /**
+   * \brief Mark the layout members at an address as covered; several
+   * members share an offset when some are empty (e.g., \c [[no_unique_address]])
+   *
+   * \param[in] addr the address passed to the hook
+   *
+   * \return whether the address is the start of a member in the layout
+   */
+  bool coverLayout(void* addr) {
+    if (layout_ == nullptr or addr < object_) {
+      return false;
+    }
+    auto const offset = static_cast<std::size_t>(
+      static_cast<char*>(addr) - static_cast<char*>(object_)
+    );
+    auto const end = layout_ + layout_count_;
+    auto const m = std::lower_bound(
+      layout_, end, offset, [](MemberLayout const& l, std::size_t o) {
+        return l.offset < o;
+      }
+    );
+    if (m == end or m->offset != offset) {
+      return false;
+    }
+    for (auto e = m; e != end and e->offset == offset; ++e) {
+      auto const i = static_cast<std::size_t>(e - layout_);
+      covered_[i / word_bits] |= uint64_t{1} << (i % word_bits);
+    }
+    return true;
+  }
+
+  uint64_t wordMask(std::size_t w) const {
+    auto const rem = layout_count_ - w * word_bits;
+    return rem >= word_bits ? ~uint64_t{0} : (uint64_t{1} << rem) - 1;
+  }
+
+  uint64_t offsetOf(void* addr) const {
+    return static_cast<uint64_t>(static_cast<char*>(addr) - static_cast<char*>(base_));
+  }
+
+  static std::size_t hashAddr(void* addr) {
+    auto const a = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(addr));
+    return static_cast<std::size_t>((a ^ (a >> 17)) * 0x9E3779B97F4A7C15ull >> 20);
+  }
+
+  FrameEntry& findOrInsert(void* addr, NameIDType name, NameIDType tinfo) {
+    if (index_.empty()) {
+      for (auto&& e : entries_) {
+        if (e.addr == addr) {
+          return nameEntry(e, name, tinfo);
+        }
+      }
+      entries_.emplace_back(addr, name, tinfo);
+      if (entries_.size() > linear_limit) {
+        rebuildIndex(linear_limit * 4);
+      }
+      return entries_.back();
+    }
+
+    auto const mask = index_.size() - 1;
+    for (auto i = hashAddr(addr) & mask; ; i = (i + 1) & mask) {
+      auto const pos = index_[i];
+      if (pos == 0) {
+        entries_.emplace_back(addr, name, tinfo);
+        index_[i] = static_cast<uint32_t>(entries_.size());
+        if (entries_.size() * 2 > index_.size()) {
+          rebuildIndex(index_.size() * 2);
+        }
+        return entries_.back();
+      }
+      auto& e = entries_[pos - 1];
+      if (e.addr == addr) {
+        return nameEntry(e, name, tinfo);
+      }
+    }
+  }
+
+  static FrameEntry& nameEntry(
+    FrameEntry& e, NameIDType name, NameIDType tinfo
+  ) {
+    // the first hook that knows the member name wins
+    if (e.name == no_name_id and name != no_name_id) {
+      e.name = name;
+      e.tinfo = tinfo;
+    }
+    return e;
+  }
+
+  void rebuildIndex(std::size_t capacity) {
+    index_.assign(capacity, 0);
+    auto const mask = capacity - 1;
+    for (std::size_t p = 0; p < entries_.size(); p++) {
+      auto i = hashAddr(entries_[p].addr) & mask;
+      while (index_[i] != 0) {
+        i = (i + 1) & mask;
+      }
+      index_[i] = static_cast<uint32_t>(p + 1);
+    }
+  }
+
+private:
+  static constexpr std::size_t const linear_limit = 8;
+  static constexpr std::size_t const word_bits = 64;
+
+  NameIDType name_ = no_name_id;
+  StackNodeIDType node_ = unresolved_stack_node;
+  FrameMode mode_ = FrameMode::Check;
+  /// First address seen in \c FrameMode::Fingerprint
+  void* base_ = nullptr;
+  /// Sum of the mixed offsets seen in \c FrameMode::Fingerprint
+  uint64_t fingerprint_ = 0;
+  /// Dense entries in the order they were first seen
+  std::vector<FrameEntry> entries_;
+  /// Position + 1 into \c entries_, 0 for an empty slot; empty while small
+  std::vector<uint32_t> index_;
+  /// Address of the object whose layout table is set
+  void* object_ = nullptr;
+  /// Generated layout table of the object's class, if any
+  MemberLayout const* layout_ = nullptr;
+  /// Number of entries in \c layout_
+  std::size_t layout_count_ = 0;
+  /// Bit per layout member: set once serialized or ignored
+  std::vector<uint64_t> covered_;
+  /// Byte ranges serialized in bulk
+  IntervalSet ranges_;
+  /// Hooks kept in \c FrameMode::Fingerprint for replay on a mismatch
+  std::vector<DeferredHook> deferred_;
 };
 
 }} /* end namespace checkpoint::sanitizer */
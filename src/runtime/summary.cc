@@ -0,0 +1,137 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  summary.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "summary.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <cxxabi.h>
+
+namespace checkpoint { namespace sanitizer {
+
+std::string demangleName(char const* name) {
+  int status = 0;
+
+  std::unique_ptr<char, void(*)(void*)> res {
+    abi::__cxa_demangle(name, NULL, NULL, &status),
+    std::free
+  };
+
+  return status == 0 ? res.get() : name;
+}
+
+void sortSummary(std::vector<SummaryMember>& members) {
+  for (auto&& m : members) {
+    std::sort(m.stacks.begin(), m.stacks.end(), [](
+      SummaryStack const& s1, SummaryStack const& s2
+    ) {
+      return s1.instances != s2.instances ?
+        s1.instances > s2.instances : s1.frames < s2.frames;
+    });
+  }
+  std::sort(members.begin(), members.end(), [](
+    SummaryMember const& m1, SummaryMember const& m2
+  ) {
+    if (m1.partial != m2.partial) {
+      return m2.partial;
+    }
+    return m1.instances != m2.instances ?
+      m1.instances > m2.instances : m1.name < m2.name;
+  });
+}
+
+void SummaryPrinter::banner() {
+  line(yellow() +  "===========================================\n" + reset());
+  line(
+    yellow() + "===== " +
+    green() + "Serialization Sanitizer Output" +
+    yellow() + " ======\n" +
+    reset()
+  );
+  line(yellow() + "===========================================\n" + reset());
+}
+
+void SummaryPrinter::member(SummaryMember const& m) {
+  if (m.partial) {
+    line("---- Found partially serialized member ----\n");
+    line("-------------------------------------------\n");
+    line(
+      "---- {}{}{} -- {}{} instances{}, {:.1f}% serialized ----\n",
+      bred(), m.name, reset(), bold(), m.instances, reset(), m.coverage
+    );
+  } else {
+    line("---- Found missing serialized member ----\n");
+    line("-----------------------------------------\n");
+    line(
+      "---- {}{}{} -- {}{} instances{} ----\n",
+      bred(), m.name, reset(), bold(), m.instances, reset()
+    );
+  }
+  line("---- {}type: {}{} ---- \n", magenta(), m.tinfo, reset());
+  if (m.ranks > 1) {
+    line(
+      "---- on {}{} ranks{} (first: rank {}) ----\n",
+      bold(), m.ranks, reset(), m.first_rank
+    );
+    for (auto&& bin : m.histogram) {
+      line(
+        "\t {:>8} - {:<8} instances: {} ranks\n", bin.min, bin.max, bin.ranks
+      );
+    }
+  }
+  for (std::size_t i = 0; i < m.stacks.size(); i++) {
+    auto const& stack = m.stacks.at(i);
+    line(
+      "---- {}stack {}{}, {}{} instances{} \n",
+      bd_green(), i, reset(), bold(), stack.instances, reset()
+    );
+    for (auto&& frame : stack.frames) {
+      line("\t {}{}{}\n", red(), demangleName(frame.c_str()), reset());
+    }
+  }
+  line("----------------------------------------\n");
+}
+
+}} /* end namespace checkpoint::sanitizer */
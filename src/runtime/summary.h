@@ -0,0 +1,206 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  summary.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_SUMMARY_H
+#define INCLUDED_SANITIZER_RUNTIME_SUMMARY_H
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct SummaryStack
+ *
+ * \brief A call stack a member was reached through, with its instances
+ */
+struct SummaryStack {
+  /// The (mangled) type names of the frames, innermost first
+  std::vector<std::string> frames;
+  uint64_t instances = 0;
+};
+
+/**
+ * \struct SummaryBin
+ *
+ * \brief A bin of the histogram of a member's instances per rank
+ */
+struct SummaryBin {
+  /// The range of instances on a rank covered by the bin
+  uint64_t min = 0;
+  uint64_t max = 0;
+  /// The number of ranks in the bin
+  uint64_t ranks = 0;
+};
+
+/**
+ * \struct SummaryMember
+ *
+ * \brief A missing or partially serialized member as reported in the summary
+ */
+struct SummaryMember {
+  std::string name;
+  std::string tinfo;
+  uint64_t instances = 0;
+  /// Whether the member was partially serialized rather than missing
+  bool partial = false;
+  /// Percentage of the member's bytes serialized, when partial
+  double coverage = 0.0;
+  /// Number of ranks the member was found on and the lowest of them
+  uint64_t ranks = 0;
+  uint64_t first_rank = 0;
+  /// Non-empty bins of the instances per rank
+  std::vector<SummaryBin> histogram;
+  std::vector<SummaryStack> stacks;
+};
+
+/**
+ * \brief Demangle a type name, returning it unchanged if it is not mangled
+ *
+ * \param[in] name the name
+ *
+ * \return the demangled name
+ */
+std::string demangleName(char const* name);
+
+/**
+ * \brief Sort members (missing before partial) and their stacks by instances,
+ * breaking ties by name so the order is reproducible
+ *
+ * \param[in,out] members the members
+ */
+void sortSummary(std::vector<SummaryMember>& members);
+
+/**
+ * \struct SummaryPrinter
+ *
+ * \brief Renders the sanitizer summary line by line, each prefixed with the
+ * process that produced it (omitted for pid 0, e.g., merged reports), into a
+ * buffer written at once
+ */
+struct SummaryPrinter {
+
+  SummaryPrinter(FILE* in_fd, pid_t in_pid, bool in_colorize)
+    : fd_(in_fd),
+      pid_(in_pid),
+      colorize_(in_colorize),
+      prefix_((pid_ != 0 ? proc() : "") + vtPre())
+  { }
+
+  SummaryPrinter(SummaryPrinter const&) = delete;
+  SummaryPrinter& operator=(SummaryPrinter const&) = delete;
+
+  ~SummaryPrinter() { flush(); }
+
+  /**
+   * \brief Write the lines buffered so far with one write
+   */
+  void flush() {
+    if (buf_.size() > 0) {
+      std::fwrite(buf_.data(), 1, buf_.size(), fd_);
+      std::fflush(fd_);
+      buf_.clear();
+    }
+  }
+
+  /**
+   * \brief Print the banner that starts a summary
+   */
+  void banner();
+
+  /**
+   * \brief Print a line of the summary
+   *
+   * \param[in] line the format string
+   * \param[in] args the format arguments
+   */
+  template <typename... Args>
+  void line(std::string const& line, Args&&... args) {
+    buf_.append(prefix_.data(), prefix_.data() + prefix_.size());
+    fmt::format_to(buf_, line, std::forward<Args>(args)...);
+  }
+
+  /**
+   * \brief Print a missing or partially serialized member with its stacks
+   *
+   * \param[in] member the member
+   */
+  void member(SummaryMember const& member);
+
+  std::string green()    const { return colorize_ ? "\033[32m"   : ""; }
+  std::string bold()     const { return colorize_ ? "\033[1m"    : ""; }
+  std::string magenta()  const { return colorize_ ? "\033[95m"   : ""; }
+  std::string red()      const { return colorize_ ? "\033[31m"   : ""; }
+  std::string bred()     const { return colorize_ ? "\033[31;1m" : ""; }
+  std::string reset()    const { return colorize_ ? "\033[00m"   : ""; }
+  std::string bd_green() const { return colorize_ ? "\033[32;1m" : ""; }
+  std::string yellow()   const { return colorize_ ? "\033[33m"   : ""; }
+  std::string blue()     const { return colorize_ ? "\033[34m"   : ""; }
+
+private:
+  std::string vtPre() const {
+    return bd_green() + std::string("vt:sanitizer") + reset() + ": ";
+  }
+  std::string proc() const {
+    return blue() + "" + std::to_string(pid_) + ":" + reset();
+  }
+
+private:
+  FILE* fd_ = nullptr;
+  pid_t pid_ = 0;
+  bool colorize_ = true;
+  /// The prefix of every line
+  std::string prefix_;
+  /// Lines not written yet
+  fmt::memory_buffer buf_;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_SUMMARY_H*/
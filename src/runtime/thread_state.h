@@ -0,0 +1,177 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                thread_state.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_THREAD_STATE_H
+#define INCLUDED_SANITIZER_RUNTIME_THREAD_STATE_H
+
+#include "runtime_interface.h"
+#include "name_table.h"
+#include "stack_record.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct ThreadState
+ *
+ * \brief Sanitizer state owned by a single serializing thread. Each thread
+ * walks its own stack of frames, so the hooks take no locks outside of
+ * recording a missing member.
+ */
+struct ThreadState {
+
+  explicit ThreadState(uint64_t profile_period)
+    : profile(profile_period)
+  { }
+
+  /// Cache in front of the process-wide name table
+  NameIndex names;
+  /// Pool of stack frames; the first \c depth are live, the rest are kept
+  /// (with their capacity) for reuse by later pushes
+  std::vector<StackRecord> stack;
+  /// Number of live frames in \c stack
+  std::size_t depth = 0;
+  /// Number of frames pushed; the \c frames_ counters are only written by
+  /// the owning thread (\c ThreadProfile::bump) and read by reports
+  std::atomic<uint64_t> frames_pushed{0};
+  /// Number of pushes that reused a pooled frame instead of constructing one
+  std::atomic<uint64_t> frames_reused{0};
+  /// Number of objects sampled out instead of checked, not counting the
+  /// objects nested in them; neither is pushed as a frame
+  std::atomic<uint64_t> frames_skipped{0};
+  /// Number of frames of proven types only fingerprinted instead of checked
+  std::atomic<uint64_t> frames_fingerprinted{0};
+  /// Self-profiling counters of the thread
+  ThreadProfile profile;
+
+  /**
+   * \brief The mode of the innermost live frame
+   */
+  FrameMode mode() const {
+    return depth > 0 ? stack[depth - 1].getMode() : FrameMode::Check;
+  }
+
+  /**
+   * \brief Handle a hook without touching the frame table when the innermost
+   * frame is only fingerprinted; a fingerprinted frame keeps the hook for
+   * replay
+   *
+   * \param[in] addr the address passed to the hook
+   * \param[in] bit the state bit for the hook
+   * \param[in] hook_fn makes the \c DeferredHook for the hook
+   *
+   * \return whether the hook is fully handled
+   */
+  template <typename HookFn>
+  bool shortCircuit(void* addr, uint8_t bit, HookFn&& hook_fn) {
+    switch (mode()) {
+    case FrameMode::Fingerprint: {
+      auto hook = hook_fn();
+      stack[depth - 1].fingerprint(addr, bit, hook.bytes);
+      stack[depth - 1].defer(std::move(hook));
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+};
+
+/**
+ * \struct ThreadTotals
+ *
+ * \brief Counters of several threads summed together, for the threads that
+ * have exited and for a report over all threads
+ */
+struct ThreadTotals {
+  uint64_t frames_pushed = 0;
+  uint64_t frames_reused = 0;
+  uint64_t frames_skipped = 0;
+  uint64_t frames_fingerprinted = 0;
+  std::array<uint64_t, num_hook_kinds> calls = {};
+  uint64_t max_depth = 0;
+  uint64_t checks = 0;
+  uint64_t timed_calls = 0;
+  /// Estimated time spent in hooks
+  uint64_t inside_ns = 0;
+  /// Time the threads existed for
+  uint64_t thread_ns = 0;
+  /// Number of threads summed
+  std::size_t threads = 0;
+
+  /**
+   * \brief Add the counters of a thread, which may still be running
+   *
+   * \param[in] ts the thread's state
+   * \param[in] now the end of the thread's lifetime so far
+   */
+  void add(ThreadState const& ts, uint64_t now) {
+    auto const get = [](std::atomic<uint64_t> const& counter) {
+      return counter.load(std::memory_order_relaxed);
+    };
+    frames_pushed += get(ts.frames_pushed);
+    frames_reused += get(ts.frames_reused);
+    frames_skipped += get(ts.frames_skipped);
+    frames_fingerprinted += get(ts.frames_fingerprinted);
+    auto const& p = ts.profile;
+    for (std::size_t i = 0; i < num_hook_kinds; i++) {
+      calls[i] += get(p.calls[i]);
+    }
+    max_depth = std::max(max_depth, get(p.max_depth));
+    checks += get(p.checks);
+    timed_calls += get(p.timed_calls);
+    inside_ns += p.insideNs();
+    thread_ns += now - p.start_ns;
+    threads++;
+  }
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_THREAD_STATE_H*/
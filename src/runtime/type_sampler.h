@@ -0,0 +1,204 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                type_sampler.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_TYPE_SAMPLER_H
+#define INCLUDED_SANITIZER_RUNTIME_TYPE_SAMPLER_H
+
+#include "config.h"
+#include "type_table.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct TypeSampler
+ *
+ * \brief Decides on one thread whether the objects it pushes are checked,
+ * before their types are interned: a flat open-addressing map from a type
+ * name (by precomputed hash and content) to the shared \c TypeState and the
+ * number of objects of the type the thread has pushed, and the thread's
+ * random number generator. Only the first object of a type on the thread
+ * looks up the type in the runtime.
+ */
+struct TypeSampler {
+
+  /// The sampling state of a type on the thread
+  struct Slot {
+    uint64_t hash = 0;
+    char const* str = nullptr;
+    TypeState* type = nullptr;
+    /// Objects of the type pushed by the thread
+    uint64_t seen = 0;
+  };
+
+  TypeSampler()
+    : slots_(initial_capacity)
+  {
+    static std::atomic<uint64_t> next_seed{1};
+    rng_ ^= next_seed.fetch_add(1) * 0xBF58476D1CE4E5B9ull;
+  }
+
+  /**
+   * \brief Find the sampling state of a type
+   *
+   * \param[in] str the type name
+   * \param[in] hash the hash of the type name
+   *
+   * \return the state or \c nullptr if the thread has not seen the type
+   */
+  Slot* find(char const* str, uint64_t hash) {
+    auto& s = slots_[probe(slots_, str, hash)];
+    return s.type != nullptr ? &s : nullptr;
+  }
+
+  /**
+   * \brief Insert the sampling state of a type that is not present
+   *
+   * \param[in] str the type name, which must outlive the sampler
+   * \param[in] hash the hash of the type name
+   * \param[in] type the shared state of the type
+   *
+   * \return the new state
+   */
+  Slot& insert(char const* str, uint64_t hash, TypeState* type) {
+    // keep the load factor at or below one half
+    if ((count_ + 1) * 2 > slots_.size()) {
+      std::vector<Slot> grown(slots_.size() * 2);
+      for (auto&& s : slots_) {
+        if (s.type != nullptr) {
+          grown[probe(grown, s.str, s.hash)] = s;
+        }
+      }
+      std::swap(grown, slots_);
+    }
+    auto& s = slots_[probe(slots_, str, hash)];
+    s = Slot{hash, str, type, 0};
+    count_++;
+    return s;
+  }
+
+  /**
+   * \brief Forget every type, when the thread moves to another runtime
+   */
+  void clear() {
+    slots_.assign(initial_capacity, Slot{});
+    count_ = 0;
+  }
+
+  /**
+   * \brief Decide whether the next object of a type is checked
+   *
+   * \param[in,out] slot the sampling state of the type
+   * \param[in] config the sampling configuration
+   *
+   * \return whether the object is checked
+   */
+  bool select(Slot& slot, SampleConfig const& config) {
+    auto const n = slot.seen++;
+    auto& type = *slot.type;
+
+    if (type.retired.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (config.every > 1 and n % config.every != 0) {
+      return false;
+    }
+    if (config.probability < 1.0 and random() >= config.probability) {
+      return false;
+    }
+    // the budget is approximate when threads race for the last checks
+    if (
+      config.budget > 0 and
+      type.checked.load(std::memory_order_relaxed) >= config.budget
+    ) {
+      return false;
+    }
+    type.checked.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * \brief Draw a uniform random number in [0, 1) (xorshift64*)
+   */
+  double random() {
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    return static_cast<double>((rng_ * 2685821657736338717ull) >> 11) /
+      9007199254740992.0;
+  }
+
+private:
+  static std::size_t probe(
+    std::vector<Slot> const& slots, char const* str, uint64_t hash
+  ) {
+    auto const mask = slots.size() - 1;
+    for (auto i = static_cast<std::size_t>(hash) & mask; ; i = (i + 1) & mask) {
+      auto const& s = slots[i];
+      if (s.type == nullptr) {
+        return i;
+      }
+      if (s.hash == hash and (s.str == str or std::strcmp(s.str, str) == 0)) {
+        return i;
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t const initial_capacity = 64;
+
+  /// Open-addressed slots; size is always a power of two
+  std::vector<Slot> slots_;
+  /// Number of occupied slots
+  std::size_t count_ = 0;
+  /// State of the random number generator
+  uint64_t rng_ = 0x9E3779B97F4A7C15ull;
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_TYPE_SAMPLER_H*/
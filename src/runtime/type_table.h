@@ -0,0 +1,186 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 type_table.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RUNTIME_TYPE_TABLE_H
+#define INCLUDED_SANITIZER_RUNTIME_TYPE_TABLE_H
+
+#include "runtime_interface.h"
+
+#include <array>
+#include <atomic>
+
+namespace checkpoint { namespace sanitizer {
+
+/**
+ * \struct TypeState
+ *
+ * \brief Per-type state shared by all threads, indexed by the interned ID of
+ * the type pushed on the sanitizer stack
+ */
+struct TypeState {
+  /// Number of objects of this type selected for checking
+  std::atomic<uint64_t> checked{0};
+  /// Consecutive checked objects without missing members
+  std::atomic<uint64_t> clean{0};
+  /// Whether checking this type stopped after enough clean validations
+  std::atomic<bool> retired{false};
+  /// Offset fingerprint of the last clean validation of this type
+  std::atomic<uint64_t> signature{0};
+  /// Consecutive clean validations with the same fingerprint
+  std::atomic<uint64_t> stable{0};
+  /// Whether the layout is proven: objects are only fingerprinted
+  std::atomic<bool> proven{false};
+  /// Number of times a fingerprint mismatch sent the type back to checking
+  std::atomic<uint64_t> escalations{0};
+};
+
+/**
+ * \struct TypeTable
+ *
+ * \brief Dense table of \c TypeState indexed by type ID. Entries live in
+ * fixed-size chunks allocated on first use, reached through directories of
+ * chunks also allocated on first use, so entries never move, the table can be
+ * indexed concurrently without locks, and it covers every type ID.
+ */
+struct TypeTable {
+
+  TypeTable() = default;
+  TypeTable(TypeTable const&) = delete;
+  TypeTable& operator=(TypeTable const&) = delete;
+
+  ~TypeTable() {
+    for (auto&& d : dirs_) {
+      auto dir = d.load();
+      if (dir != nullptr) {
+        for (auto&& c : *dir) {
+          delete [] c.load();
+        }
+        delete dir;
+      }
+    }
+  }
+
+  /**
+   * \brief Get the state for a type
+   *
+   * \param[in] id the type ID
+   *
+   * \return the state
+   */
+  TypeState& get(NameIDType id) {
+    auto& dir = *create(dirs_[id >> (chunk_bits + dir_bits)], [] {
+      return new Directory{};
+    });
+    auto chunk = create(dir[(id >> chunk_bits) & (dir_size - 1)], [] {
+      return new TypeState[chunk_size];
+    });
+    return chunk[id & (chunk_size - 1)];
+  }
+
+  /**
+   * \brief Apply a function to the state of every type that has any
+   *
+   * \param[in] fn the function, called with the type ID and the state
+   */
+  template <typename Fn>
+  void forEach(Fn&& fn) const {
+    for (std::size_t d = 0; d < num_dirs; d++) {
+      auto dir = dirs_[d].load(std::memory_order_acquire);
+      if (dir == nullptr) {
+        continue;
+      }
+      for (std::size_t c = 0; c < dir_size; c++) {
+        auto chunk = (*dir)[c].load(std::memory_order_acquire);
+        if (chunk != nullptr) {
+          auto const first = ((d << dir_bits) + c) << chunk_bits;
+          for (std::size_t i = 0; i < chunk_size; i++) {
+            fn(static_cast<NameIDType>(first + i), chunk[i]);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t const chunk_bits = 10;
+  static constexpr std::size_t const chunk_size = 1 << chunk_bits;
+  static constexpr std::size_t const dir_bits = 10;
+  static constexpr std::size_t const dir_size = 1 << dir_bits;
+  static constexpr std::size_t const num_dirs =
+    std::size_t{1} << (sizeof(NameIDType) * 8 - chunk_bits - dir_bits);
+
+  using Directory = std::array<std::atomic<TypeState*>, dir_size>;
+
+  /**
+   * \brief Get the pointee of a slot, allocating it when the slot is empty;
+   * a thread that loses the race for the slot frees its allocation
+   *
+   * \param[in,out] slot the slot
+   * \param[in] make allocates the pointee
+   *
+   * \return the pointee
+   */
+  template <typename T, typename Make>
+  static T* create(std::atomic<T*>& slot, Make&& make) {
+    auto ptr = slot.load(std::memory_order_acquire);
+    if (ptr == nullptr) {
+      auto fresh = make();
+      if (slot.compare_exchange_strong(ptr, fresh)) {
+        ptr = fresh;
+      } else {
+        destroy(fresh);
+      }
+    }
+    return ptr;
+  }
+
+  static void destroy(Directory* dir) { delete dir; }
+  static void destroy(TypeState* chunk) { delete [] chunk; }
+
+  std::array<std::atomic<Directory*>, num_dirs> dirs_ = {};
+};
+
+}} /* end namespace checkpoint::sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RUNTIME_TYPE_TABLE_H*/
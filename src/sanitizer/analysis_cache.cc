@@ -0,0 +1,386 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                              analysis_cache.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "common.h"
+#include "analysis_cache.h"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecordLayout.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace sanitizer {
+
+/// Bump when the format of entries or the generated code changes
+static constexpr char const* cache_version = "sanitizer-cache-3";
+
+AnalysisCache::AnalysisCache(std::string const& in_dir) {
+  llvm::SmallString<256> dir{in_dir};
+  llvm::sys::fs::make_absolute(dir);
+  dir_ = dir.str().str();
+  llvm::sys::fs::create_directories(dir_ + "/tu");
+  llvm::sys::fs::create_directories(dir_ + "/record");
+}
+
+std::string AnalysisCache::path(char const* kind, HashType key) const {
+  return fmt::format("{}/{}/{}", dir_, kind, hashString(key));
+}
+
+/*static*/ bool AnalysisCache::hashFile(std::string const& path, HashType& hash) {
+  auto buf = llvm::MemoryBuffer::getFile(path);
+  if (not buf) {
+    return false;
+  }
+  hash = hashBytes((*buf)->getBuffer());
+  return true;
+}
+
+static llvm::StringRef sourceText(clang::Decl const* d) {
+  auto const& ctx = d->getASTContext();
+  return clang::Lexer::getSourceText(
+    clang::CharSourceRange::getTokenRange(d->getSourceRange()),
+    ctx.getSourceManager(), ctx.getLangOpts()
+  );
+}
+
+// The content hash of the file a location is in, memoized for the TU
+static HashType hashFileAt(
+  clang::SourceManager const& sm, clang::SourceLocation loc, FileHashMemo& memo
+) {
+  if (loc.isInvalid()) {
+    return 0;
+  }
+  auto const fid = sm.getFileID(loc);
+  auto iter = memo.find(fid.getHashValue());
+  if (iter == memo.end()) {
+    bool invalid = false;
+    auto const data = sm.getBufferData(fid, &invalid);
+    iter = memo.emplace(fid.getHashValue(), invalid ? 0 : hashBytes(data)).first;
+  }
+  return iter->second;
+}
+
+// Chain the hashes of the files a declaration is written in: where it is
+// expanded and, for a declaration produced by a macro, where it is spelled
+static HashType hashDeclFiles(
+  clang::Decl const* d, FileHashMemo& memo, HashType h
+) {
+  if (d == nullptr) {
+    return h;
+  }
+  auto const& sm = d->getASTContext().getSourceManager();
+  auto const loc = d->getLocation();
+  h ^= hashFileAt(sm, sm.getExpansionLoc(loc), memo);
+  h *= 0x100000001b3ull;
+  h ^= hashFileAt(sm, sm.getSpellingLoc(loc), memo);
+  h *= 0x100000001b3ull;
+  return h;
+}
+
+/*static*/ bool AnalysisCache::recordKey(
+  clang::CXXRecordDecl const* rd, FileHashMemo& memo, HashType& key
+) {
+  if (rd == nullptr or not rd->isThisDeclarationADefinition()) {
+    return false;
+  }
+
+  // The generated code depends on the record, its serialize definitions
+  // (existing checks are skipped) and, for instantiations, the arguments
+  HashType h = hashBytes(cache_version);
+  bool serializable = false;
+  for (auto&& m : rd->decls()) {
+    auto ft = clang::dyn_cast<clang::FunctionTemplateDecl>(m);
+    if (ft == nullptr or ft->getNameAsString() != "serialize") {
+      continue;
+    }
+    serializable = true;
+    auto fn = ft->getTemplatedDecl();
+    if (auto def = fn->getDefinition()) {
+      h = hashBytes(sourceText(def), h);
+      h = hashDeclFiles(def, memo, h);
+    }
+  }
+  if (not serializable) {
+    return false;
+  }
+
+  auto const type = clang::QualType(rd->getTypeForDecl(), 0).getAsString();
+  h = hashBytes(rd->getQualifiedNameAsString(), h);
+  h = hashBytes(type, h);
+  h = hashBytes(std::to_string(rd->getTemplateSpecializationKind()), h);
+  h = hashBytes(sourceText(rd), h);
+  h = hashDeclFiles(rd, memo, h);
+
+  // Member types, sizes and offsets (embedded by the layout tables) and the
+  // bases come from other headers: a change there must miss the cache too
+  auto const& ctx = rd->getASTContext();
+  bool const laid_out = not rd->isDependentType() and not rd->isInvalidDecl();
+  auto const* layout = laid_out ? &ctx.getASTRecordLayout(rd) : nullptr;
+  for (auto&& f : rd->fields()) {
+    auto const ft = f->getType().getCanonicalType();
+    h = hashBytes(f->getNameAsString(), h);
+    h = hashBytes(ft.getAsString(), h);
+    h = hashDeclFiles(f, memo, h);
+    if (layout != nullptr and not ft->isDependentType() and not ft->isIncompleteType()) {
+      h = hashBytes(fmt::format(
+        "{}:{}", ctx.getTypeSizeInChars(ft).getQuantity(),
+        layout->getFieldOffset(f->getFieldIndex())
+      ), h);
+    }
+    if (auto const td = ft->getAsTagDecl()) {
+      h = hashDeclFiles(td->getDefinition(), memo, h);
+    }
+  }
+  for (auto&& b : rd->bases()) {
+    auto const bt = b.getType().getCanonicalType();
+    h = hashBytes(bt.getAsString(), h);
+    auto const base = bt->getAsCXXRecordDecl();
+    if (base != nullptr and base->hasDefinition()) {
+      h = hashDeclFiles(base->getDefinition(), memo, h);
+      if (layout != nullptr and not b.isVirtual()) {
+        h = hashBytes(std::to_string(
+          layout->getBaseClassOffset(base).getQuantity()
+        ), h);
+      }
+    }
+  }
+
+  key = h;
+  return true;
+}
+
+// Write a file through a temporary that is renamed over it
+static void writeEntry(std::string const& path, std::string const& contents) {
+  int fd = -1;
+  llvm::SmallString<256> temp;
+  if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, temp)) {
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os{fd, true};
+    os << contents;
+  }
+  llvm::sys::fs::rename(temp, path);
+}
+
+/*
+ * The TU entry format is line based with length-prefixed blobs:
+ *
+ *   sanitizer-cache-3
+ *   deps <n>
+ *   <hash> <path>            (n times)
+ *   shared <n>
+ *   <hash> <len> <len>       (n times, content hash and blob lengths)
+ *   <qualified name><file><code>
+ *   records <n> <len>...     (size of the code of each record)
+ *   code <len>
+ *   <code>
+ */
+void AnalysisCache::storeTU(HashType key, CachedTU const& tu) const {
+  fmt::memory_buffer buf;
+  fmt::format_to(buf, "{}\ndeps {}\n", cache_version, tu.deps.size());
+  for (auto&& d : tu.deps) {
+    fmt::format_to(buf, "{} {}\n", hashString(d.second), d.first);
+  }
+  fmt::format_to(buf, "shared {}\n", tu.shared.size());
+  for (auto&& s : tu.shared) {
+    fmt::format_to(
+      buf, "{} {} {} {}\n{}{}{}", hashString(s.key.content_hash),
+      s.key.qual_name.size(), s.key.file.size(), s.code.size(),
+      s.key.qual_name, s.key.file, s.code
+    );
+  }
+  fmt::format_to(buf, "records {}", tu.records.size());
+  for (auto&& len : tu.records) {
+    fmt::format_to(buf, " {}", len);
+  }
+  fmt::format_to(buf, "\ncode {}\n{}", tu.code.size(), tu.code);
+  writeEntry(path("tu", key), fmt::to_string(buf));
+}
+
+namespace {
+
+struct EntryReader {
+  explicit EntryReader(llvm::StringRef in_data) : data_(in_data) { }
+
+  bool line(llvm::StringRef& out) {
+    auto const pos = data_.find('\n');
+    if (pos == llvm::StringRef::npos) {
+      return false;
+    }
+    out = data_.substr(0, pos);
+    data_ = data_.substr(pos + 1);
+    return true;
+  }
+
+  bool blob(std::size_t len, std::string& out) {
+    if (data_.size() < len) {
+      return false;
+    }
+    out = data_.substr(0, len).str();
+    data_ = data_.substr(len);
+    return true;
+  }
+
+private:
+  llvm::StringRef data_;
+};
+
+} /* end anonymous namespace */
+
+static bool parseHash(llvm::StringRef str, HashType& h) {
+  return not str.getAsInteger(16, h);
+}
+
+bool AnalysisCache::lookupTU(HashType key, CachedTU& tu) {
+  auto buf = llvm::MemoryBuffer::getFile(path("tu", key));
+  if (not buf) {
+    tu_misses_++;
+    return false;
+  }
+
+  auto const valid = [&]{
+    EntryReader r{(*buf)->getBuffer()};
+    llvm::StringRef l;
+    std::size_t n = 0;
+
+    if (not r.line(l) or l != cache_version) {
+      return false;
+    }
+
+    if (not r.line(l) or not l.consume_front("deps ") or l.getAsInteger(10, n)) {
+      return false;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      HashType expected = 0, actual = 0;
+      if (not r.line(l) or not parseHash(l.substr(0, 16), expected)) {
+        return false;
+      }
+      auto const file = l.substr(17).str();
+      // stop at the first dependency that changed
+      if (not hashFile(file, actual) or actual != expected) {
+        return false;
+      }
+      tu.deps.emplace_back(file, actual);
+    }
+
+    if (not r.line(l) or not l.consume_front("shared ") or l.getAsInteger(10, n)) {
+      return false;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+      llvm::SmallVector<llvm::StringRef, 4> fields;
+      std::size_t qual_len = 0, file_len = 0, code_len = 0;
+      CachedSharedRecord s;
+      if (not r.line(l)) {
+        return false;
+      }
+      l.split(fields, ' ');
+      if (
+        fields.size() != 4 or not parseHash(fields[0], s.key.content_hash) or
+        fields[1].getAsInteger(10, qual_len) or
+        fields[2].getAsInteger(10, file_len) or
+        fields[3].getAsInteger(10, code_len) or
+        not r.blob(qual_len, s.key.qual_name) or
+        not r.blob(file_len, s.key.file) or
+        not r.blob(code_len, s.code)
+      ) {
+        return false;
+      }
+      tu.shared.push_back(std::move(s));
+    }
+
+    llvm::SmallVector<llvm::StringRef, 16> lens;
+    if (not r.line(l) or not l.consume_front("records ")) {
+      return false;
+    }
+    l.split(lens, ' ');
+    if (lens.empty() or lens[0].getAsInteger(10, n) or lens.size() != n + 1) {
+      return false;
+    }
+    std::size_t total = 0;
+    for (std::size_t i = 1; i <= n; i++) {
+      std::size_t len = 0;
+      if (lens[i].getAsInteger(10, len)) {
+        return false;
+      }
+      tu.records.push_back(len);
+      total += len;
+    }
+
+    if (not r.line(l) or not l.consume_front("code ") or l.getAsInteger(10, n)) {
+      return false;
+    }
+    return total <= n and r.blob(n, tu.code);
+  }();
+
+  if (not valid) {
+    tu = CachedTU{};
+    tu_misses_++;
+    return false;
+  }
+  tu_hits_++;
+  return true;
+}
+
+bool AnalysisCache::lookupRecord(HashType key, std::string& code) {
+  auto buf = llvm::MemoryBuffer::getFile(path("record", key));
+  if (not buf) {
+    record_misses_++;
+    return false;
+  }
+  code = (*buf)->getBuffer().str();
+  record_hits_++;
+  return true;
+}
+
+void AnalysisCache::storeRecord(HashType key, std::string const& code) const {
+  writeEntry(path("record", key), code);
+}
+
+} /* end namespace sanitizer */
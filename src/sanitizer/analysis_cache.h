@@ -0,0 +1,191 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               analysis_cache.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_ANALYSIS_CACHE_H
+#define INCLUDED_SANITIZER_ANALYSIS_CACHE_H
+
+#include "common.h"
+#include "hash.h"
+#include "shared_records.h"
+
+#include "clang/AST/DeclCXX.h"
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sanitizer {
+
+/// Content hashes of the files of a translation unit by \c FileID
+using FileHashMemo = std::unordered_map<unsigned, HashType>;
+
+/**
+ * \struct CachedSharedRecord
+ *
+ * \brief A shared record seen by a cached translation unit with the code
+ * generated for it (empty if it has none)
+ */
+struct CachedSharedRecord {
+  RecordKey key;
+  std::string code;
+};
+
+/**
+ * \struct CachedTU
+ *
+ * \brief The cached result of a translation unit: the files it depends on
+ * with their content hashes, the shared records it saw and its output
+ */
+struct CachedTU {
+  std::vector<std::pair<std::string, HashType>> deps;
+  std::vector<CachedSharedRecord> shared;
+  /// Size of the code generated for each record, in order
+  std::vector<std::size_t> records;
+  std::string code;
+};
+
+/**
+ * \struct AnalysisCache
+ *
+ * \brief Persistent on-disk cache of analysis results, shared across runs.
+ *
+ * At the translation unit level, the output of a TU is keyed by its file,
+ * compile command and the tool options, and is valid while the content hash
+ * of every file the TU read is unchanged: a hit skips parsing entirely. At the
+ * record level, the code generated for a serializable record is keyed by the
+ * hash of its source text, the source text of its serialize definitions, its
+ * qualified type, its member layout and bases and the files they come from,
+ * so TUs that must be reparsed only re-walk records that changed.
+ *
+ * Entries are written to a temporary file and renamed, so concurrent TUs and
+ * concurrent runs never observe partial entries.
+ */
+struct AnalysisCache {
+
+  explicit AnalysisCache(std::string const& in_dir);
+
+  /**
+   * \brief Hash the contents of a file
+   *
+   * \param[in] path the file
+   * \param[out] hash the hash
+   *
+   * \return whether the file could be read
+   */
+  static bool hashFile(std::string const& path, HashType& hash);
+
+  /**
+   * \brief Compute the cache key of a serializable record: its source text
+   * and serialize definitions, the canonical types, sizes and offsets of its
+   * members, its bases, and the content hashes of the files all of these are
+   * declared in (including where macros producing them are spelled)
+   *
+   * \param[in] rd the record
+   * \param[in,out] memo the file hashes of the record's TU computed so far
+   * \param[out] key the key
+   *
+   * \return whether the record is serializable and can be cached
+   */
+  static bool recordKey(
+    clang::CXXRecordDecl const* rd, FileHashMemo& memo, HashType& key
+  );
+
+  /**
+   * \brief Look up a translation unit; the entry is only returned if none of
+   * the files it depends on changed
+   *
+   * \param[in] key the translation unit key
+   * \param[out] tu the cached translation unit
+   *
+   * \return whether there was a valid entry
+   */
+  bool lookupTU(HashType key, CachedTU& tu);
+
+  /**
+   * \brief Store a translation unit
+   *
+   * \param[in] key the translation unit key
+   * \param[in] tu the translation unit
+   */
+  void storeTU(HashType key, CachedTU const& tu) const;
+
+  /**
+   * \brief Look up the code generated for a record
+   *
+   * \param[in] key the record key
+   * \param[out] code the generated code
+   *
+   * \return whether there was an entry
+   */
+  bool lookupRecord(HashType key, std::string& code);
+
+  /**
+   * \brief Store the code generated for a record
+   *
+   * \param[in] key the record key
+   * \param[in] code the generated code
+   */
+  void storeRecord(HashType key, std::string const& code) const;
+
+  std::size_t tuHits() const { return tu_hits_.load(); }
+  std::size_t tuMisses() const { return tu_misses_.load(); }
+  std::size_t recordHits() const { return record_hits_.load(); }
+  std::size_t recordMisses() const { return record_misses_.load(); }
+
+private:
+  std::string path(char const* kind, HashType key) const;
+
+private:
+  std::string dir_;
+  std::atomic<std::size_t> tu_hits_{0};
+  std::atomic<std::size_t> tu_misses_{0};
+  std::atomic<std::size_t> record_hits_{0};
+  std::atomic<std::size_t> record_misses_{0};
+};
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_ANALYSIS_CACHE_H*/
@@ -0,0 +1,134 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                 database.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "common.h"
+#include "database.h"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <unordered_set>
+
+namespace sanitizer {
+
+bool TUFilter::isValid(std::string& error) const {
+  return
+    dir_.isValid(error) and file_.isValid(error) and
+    (not has_ignore_ or ignore_.isValid(error));
+}
+
+bool TUFilter::matches(llvm::StringRef dir, llvm::StringRef file) const {
+  if (not dir_.match(dir) or not file_.match(file)) {
+    return false;
+  }
+  return not has_ignore_ or not ignore_.match(file);
+}
+
+std::string absolutePath(llvm::StringRef dir, llvm::StringRef file) {
+  if (llvm::sys::path::is_absolute(file)) {
+    return file.str();
+  }
+  llvm::SmallString<256> path{dir};
+  llvm::sys::path::append(path, file);
+  llvm::sys::path::remove_dots(path, true);
+  return path.str().str();
+}
+
+std::vector<std::string> selectTranslationUnits(
+  clang::tooling::CompilationDatabase const& db,
+  std::vector<std::string> const& sources, TUFilter const& filter
+) {
+  std::vector<clang::tooling::CompileCommand> commands;
+  if (sources.empty()) {
+    commands = db.getAllCompileCommands();
+  } else {
+    for (auto&& source : sources) {
+      auto cmds = db.getCompileCommands(source);
+      if (cmds.empty()) {
+        // keep the file; the tool reports the missing compile command
+        clang::tooling::CompileCommand cmd;
+        cmd.Filename = source;
+        commands.push_back(cmd);
+      } else {
+        commands.push_back(cmds.front());
+      }
+    }
+  }
+
+  std::vector<std::string> files;
+  std::unordered_set<std::string> seen;
+  for (auto&& cmd : commands) {
+    auto const path = absolutePath(cmd.Directory, cmd.Filename);
+    if (filter.matches(cmd.Directory, path) and seen.insert(path).second) {
+      files.push_back(path);
+    }
+  }
+  return files;
+}
+
+std::error_code replaceFile(std::string const& path, llvm::StringRef contents) {
+  if (auto ec = llvm::sys::fs::copy_file(path, path + ".bak")) {
+    return ec;
+  }
+
+  auto const temp = path + ".sanitizer.tmp";
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream os{temp, ec, llvm::sys::fs::F_None};
+    if (ec) {
+      return ec;
+    }
+    os << contents;
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+
+  return llvm::sys::fs::rename(temp, path);
+}
+
+} /* end namespace sanitizer */
@@ -0,0 +1,144 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                  database.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_DATABASE_H
+#define INCLUDED_SANITIZER_DATABASE_H
+
+#include "common.h"
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/Regex.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace sanitizer {
+
+/**
+ * \struct TUFilter
+ *
+ * \brief Selects translation units from a compilation database by regular
+ * expressions on the compile directory and file name, with an optional regular
+ * expression on the file name to ignore.
+ */
+struct TUFilter {
+
+  TUFilter(
+    std::string const& in_dir, std::string const& in_file,
+    std::string const& in_ignore
+  ) : dir_(in_dir.empty() ? ".*" : in_dir),
+      file_(in_file.empty() ? ".*" : in_file),
+      ignore_(in_ignore),
+      has_ignore_(not in_ignore.empty())
+  { }
+
+  /**
+   * \brief Check that all the regular expressions are valid
+   *
+   * \param[out] error the error message when invalid
+   *
+   * \return whether they are valid
+   */
+  bool isValid(std::string& error) const;
+
+  /**
+   * \brief Whether a translation unit is selected
+   *
+   * \param[in] dir the directory of the compile command
+   * \param[in] file the file of the compile command
+   *
+   * \return whether it is selected
+   */
+  bool matches(llvm::StringRef dir, llvm::StringRef file) const;
+
+private:
+  // llvm::Regex::match is not const before LLVM 10
+  mutable llvm::Regex dir_;
+  mutable llvm::Regex file_;
+  mutable llvm::Regex ignore_;
+  bool has_ignore_ = false;
+};
+
+/**
+ * \brief Make a path from a compile command absolute
+ *
+ * \param[in] dir the directory of the compile command
+ * \param[in] file the path, relative to the directory or absolute
+ *
+ * \return the absolute path without dots
+ */
+std::string absolutePath(llvm::StringRef dir, llvm::StringRef file);
+
+/**
+ * \brief Select the translation units to process, in database order and
+ * without duplicates. When no sources are given on the command line, every
+ * file in the compilation database is a candidate.
+ *
+ * \param[in] db the compilation database
+ * \param[in] sources the sources given on the command line
+ * \param[in] filter the filter to apply
+ *
+ * \return the absolute paths of the selected files
+ */
+std::vector<std::string> selectTranslationUnits(
+  clang::tooling::CompilationDatabase const& db,
+  std::vector<std::string> const& sources, TUFilter const& filter
+);
+
+/**
+ * \brief Replace the contents of a file, keeping the original in a \c .bak
+ * file next to it. The new contents are written to a temporary file that is
+ * renamed over the original.
+ *
+ * \param[in] path the file to replace
+ * \param[in] contents the new contents
+ *
+ * \return the error, if any
+ */
+std::error_code replaceFile(std::string const& path, llvm::StringRef contents);
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_DATABASE_H*/
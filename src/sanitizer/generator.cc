@@ -44,6 +44,7 @@
 
 #include "common.h"
 #include "generator.h"
+#include "phase_timer.h"
 
 #include "qualified_name.h"
 
@@ -51,6 +52,9 @@
 
 #include <list>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace sanitizer {
 
@@ -94,6 +98,7 @@ void InlineGenerator::run(
 static constexpr char const* sanitizer = "checkpoint::serializers::Sanitizer";
 static constexpr char const* begin = "{";
 static constexpr char const* end = "}";
+static constexpr char const* runtime_ns = "::checkpoint::sanitizer";
 
 void PartialSpecializationGenerator::run(
   clang::CXXRecordDecl const* rd, clang::FunctionDecl* fn,
@@ -108,17 +113,19 @@ void PartialSpecializationGenerator::run(
   TemplateSpecializationKind kind = rd->getTemplateSpecializationKind();
 
   if (kind == TemplateSpecializationKind::TSK_Undeclared) {
-    auto qual_name = rd->getQualifiedNameAsString();
+    std::string qual_name;
+    {
+      ScopedPhase phase{Phase::TypeName};
+      qual_name = rd->getQualifiedNameAsString();
+    }
 
-    fmt::print(out_, "template <>\n");
-    fmt::print(
+    fmt::format_to(out_, "template <>\n");
+    fmt::format_to(
       out_, "inline void {}::serialize<{}>({}& s) {}\n",
       qual_name, sanitizer, sanitizer, begin
     );
-    for (auto&& m : members) {
-      fmt::print(out_, "  s.check({}, \"{}\");\n", m.unqual(), m.qual());
-    }
-    fmt::print(out_, "{}\n", end);
+    generateBody(rd, qual_name, members);
+    fmt::format_to(out_, "{}\n", end);
   } else if (kind == TemplateSpecializationKind::TSK_ImplicitInstantiation) {
     if (
       clang::isa<clang::ClassTemplateSpecializationDecl>(rd) or
@@ -130,24 +137,134 @@ void PartialSpecializationGenerator::run(
       policy.PolishForDeclaration = true;
       policy.SuppressUnwrittenScope = true;
 
-      auto qt = clang::TypeName2::getFullyQualifiedType(
-        clang::QualType(rd->getTypeForDecl(),0), rd->getASTContext(), false
-      );
-
-      std::string qualified_type_outer = qt.getAsString(policy);
+      std::string qualified_type_outer;
+      {
+        ScopedPhase phase{Phase::TypeName};
+        auto qt = clang::TypeName2::getFullyQualifiedType(
+          clang::QualType(rd->getTypeForDecl(),0), rd->getASTContext(), false
+        );
+        qualified_type_outer = qt.getAsString(policy);
+      }
 
-      fmt::print(out_, "template <>\n");
-      fmt::print(out_, "template <>\n");
-      fmt::print(
+      fmt::format_to(out_, "template <>\n");
+      fmt::format_to(out_, "template <>\n");
+      fmt::format_to(
         out_, "inline void {}::serialize<{}>({}& s) {}\n", qualified_type_outer,
         sanitizer, sanitizer, begin
       );
-      for (auto&& m : members) {
-        fmt::print(out_,"  s.check({}, \"{}\");\n", m.unqual(), m.qual());
-      }
-      fmt::print(out_,"{}\n", end);
+      generateBody(rd, qualified_type_outer, members);
+      fmt::format_to(out_,"{}\n", end);
+    }
+  }
+}
+
+void PartialSpecializationGenerator::generateBody(
+  clang::CXXRecordDecl const* rd, std::string const& type,
+  MemberListType const& members
+) {
+  // StaticName hashes the member name at compile time, so the runtime interns
+  // it without allocating
+  for (auto&& m : members) {
+    fmt::format_to(
+      out_, "  s.check({}, {}::StaticName{}\"{}\"{});\n", m.unqual(),
+      runtime_ns, begin, m.qual(), end
+    );
+  }
+}
+
+// The bytes of a type that hold data: its size without the padding of the
+// records it contains
+static uint64_t dataSize(clang::QualType type, clang::ASTContext& ctx) {
+  type = type.getCanonicalType();
+  if (auto array = ctx.getAsConstantArrayType(type)) {
+    return ctx.getConstantArrayElementCount(array) *
+      dataSize(ctx.getBaseElementType(array), ctx);
+  }
+
+  auto rd = type->getAsCXXRecordDecl();
+  if (rd == nullptr or not rd->hasDefinition() or rd->isUnion()) {
+    return static_cast<uint64_t>(ctx.getTypeSizeInChars(type).getQuantity());
+  }
+
+  uint64_t size = 0;
+  for (auto&& base : rd->bases()) {
+    if (not base.isVirtual()) {
+      size += dataSize(base.getType(), ctx);
+    }
+  }
+  for (auto&& f : rd->fields()) {
+    if (f->isBitField()) {
+      size += (f->getBitWidthValue(ctx) + 7) / 8;
+    } else if (not f->getType()->isReferenceType()) {
+      size += dataSize(f->getType(), ctx);
     }
   }
+  return size;
+}
+
+void LayoutGenerator::generateBody(
+  clang::CXXRecordDecl const* rd, std::string const& type,
+  MemberListType const& members
+) {
+  // offsetof is ill-formed for members of classes with virtual bases
+  if (rd->getNumVBases() > 0) {
+    PartialSpecializationGenerator::generateBody(rd, type, members);
+    return;
+  }
+
+  std::unordered_map<std::string, clang::FieldDecl const*> fields;
+  for (auto&& f : rd->fields()) {
+    fields[f->getNameAsString()] = f;
+  }
+
+  // Bit-fields and references have no offset of their own; they are still
+  // checked one by one
+  MemberListType fallback;
+  std::vector<std::pair<Member, clang::FieldDecl const*>> entries;
+  for (auto&& m : members) {
+    auto iter = fields.find(m.unqual());
+    if (
+      iter == fields.end() or iter->second->isBitField() or
+      iter->second->getType()->isReferenceType()
+    ) {
+      fallback.push_back(m);
+    } else {
+      entries.emplace_back(m, iter->second);
+    }
+  }
+
+  PartialSpecializationGenerator::generateBody(rd, type, fallback);
+
+  if (entries.empty()) {
+    return;
+  }
+
+  // offsetof is a macro: name the type through an alias so template argument
+  // lists do not split its arguments
+  fmt::format_to(out_, "  using sanitizer_self_type = {};\n", type);
+  fmt::format_to(out_, "#pragma GCC diagnostic push\n");
+  fmt::format_to(out_, "#pragma GCC diagnostic ignored \"-Winvalid-offsetof\"\n");
+  // The type names come from typeid, like the names passed by the check()
+  // path, so both key a member by the same type name; typeid is not constant,
+  // so the table is initialized the first time the object is sanitized
+  fmt::format_to(
+    out_, "  static {}::MemberLayout const sanitizer_layout[] = {}\n",
+    runtime_ns, begin
+  );
+  for (auto&& e : entries) {
+    fmt::format_to(
+      out_,
+      "    {}offsetof(sanitizer_self_type, {}), "
+      "sizeof(sanitizer_self_type::{}), {}, {}::StaticName{}\"{}\"{}, "
+      "{}::staticTypeName<decltype(sanitizer_self_type::{})>(){},\n",
+      begin, e.first.unqual(), e.first.unqual(),
+      dataSize(e.second->getType(), rd->getASTContext()), runtime_ns, begin,
+      e.first.qual(), end, runtime_ns, e.first.unqual(), end
+    );
+  }
+  fmt::format_to(out_, "  {};\n", end);
+  fmt::format_to(out_, "#pragma GCC diagnostic pop\n");
+  fmt::format_to(out_, "  s.checkLayout(this, sanitizer_layout);\n");
 }
 
 void SeperateGenerator::run(
@@ -217,7 +334,10 @@ void SeperateGenerator::run(
     qual_name, template_def_context
   );
   for (auto&& m : members) {
-    fmt::print("\ts.check(obj.{}, \"{}\");\n", m.unqual(), m.qual());
+    fmt::print(
+      "\ts.check(obj.{}, {}::StaticName{}\"{}\"{});\n", m.unqual(), runtime_ns,
+      begin, m.qual(), end
+    );
   }
   fmt::print("}\n\n");
 }
@@ -51,6 +51,10 @@
 #include "clang/AST/ExprCXX.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 
+#include <fmt/format.h>
+
+#include <string>
+
 namespace sanitizer {
 
 /**
@@ -101,10 +105,12 @@ private:
  * \struct PartialSpecializationGenerator
  *
  * \brief Generates checks in a partial specialization of the serialize method.
+ * The code is appended to the output buffer of the translation unit being
+ * processed.
  */
 struct PartialSpecializationGenerator : Generator {
 
-  explicit PartialSpecializationGenerator(FILE* in_out)
+  explicit PartialSpecializationGenerator(fmt::memory_buffer& in_out)
     : out_(in_out)
   { }
 
@@ -113,8 +119,41 @@ struct PartialSpecializationGenerator : Generator {
     MemberListType members
   ) override;
 
-private:
-  FILE* out_ = nullptr;
+protected:
+  /**
+   * \brief Generate the body of the specialization
+   *
+   * \param[in] rd the class
+   * \param[in] type the fully qualified type of the class
+   * \param[in] members the list of fields to check
+   */
+  virtual void generateBody(
+    clang::CXXRecordDecl const* rd, std::string const& type,
+    MemberListType const& members
+  );
+
+protected:
+  fmt::memory_buffer& out_;
+};
+
+/**
+ * \struct LayoutGenerator
+ *
+ * \brief Generates a partial specialization that hands a \c constexpr table of
+ * member offsets, sizes and names to the serializer with a single
+ * \c checkLayout call, instead of one \c check call per member.
+ */
+struct LayoutGenerator : PartialSpecializationGenerator {
+
+  explicit LayoutGenerator(fmt::memory_buffer& in_out)
+    : PartialSpecializationGenerator(in_out)
+  { }
+
+protected:
+  void generateBody(
+    clang::CXXRecordDecl const* rd, std::string const& type,
+    MemberListType const& members
+  ) override;
 };
 
 /**
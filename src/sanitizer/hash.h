@@ -0,0 +1,94 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                    hash.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_HASH_H
+#define INCLUDED_SANITIZER_HASH_H
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include <fmt/format.h>
+
+namespace sanitizer {
+
+using HashType = uint64_t;
+
+/// Initial value of a hash, chained through \c hashBytes
+static constexpr HashType const hash_seed = 0xcbf29ce484222325ull;
+
+/**
+ * \brief Stable 64-bit FNV-1a hash of a byte string; the value does not depend
+ * on the platform or the run, so it can be stored on disk and compared across
+ * runs
+ *
+ * \param[in] bytes the bytes to hash
+ * \param[in] seed the hash to chain from
+ *
+ * \return the hash
+ */
+inline HashType hashBytes(llvm::StringRef bytes, HashType seed = hash_seed) {
+  HashType h = seed;
+  for (auto c : bytes) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+/**
+ * \brief Format a hash as a fixed-width hexadecimal string
+ *
+ * \param[in] h the hash
+ *
+ * \return the string
+ */
+inline std::string hashString(HashType h) {
+  return fmt::format("{:016x}", h);
+}
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_HASH_H*/
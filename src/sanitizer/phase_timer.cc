@@ -0,0 +1,177 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                phase_timer.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "phase_timer.h"
+
+#include <chrono>
+#include <time.h>
+
+namespace sanitizer {
+
+namespace {
+
+/// Phases nest at most a few levels deep (parse, match, walk, type name)
+static constexpr std::size_t const max_depth = 16;
+
+uint64_t wallNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()
+  ).count();
+}
+
+uint64_t cpuNow() {
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+struct ThreadTimer {
+  TUStats* stats = nullptr;
+  uint64_t start_wall = 0, start_cpu = 0;
+  uint64_t last_wall = 0, last_cpu = 0;
+  std::array<Phase, max_depth> stack;
+  std::size_t depth = 0;
+
+  // Charge the time since the last transition to the innermost phase
+  void charge() {
+    auto const wall = wallNow();
+    auto const cpu = cpuNow();
+    if (depth > 0 and depth <= max_depth) {
+      auto const phase = static_cast<std::size_t>(stack[depth - 1]);
+      stats->wall_ns[phase] += wall - last_wall;
+      stats->cpu_ns[phase] += cpu - last_cpu;
+    }
+    last_wall = wall;
+    last_cpu = cpu;
+  }
+};
+
+thread_local ThreadTimer timer;
+
+} /* end anon namespace */
+
+char const* skipReasonName(SkipReason reason) {
+  switch (reason) {
+  case SkipReason::SystemHeader:    return "system-header";
+  case SkipReason::NoSerialize:     return "no-serialize";
+  case SkipReason::ExcludedPath:    return "excluded-path";
+  case SkipReason::TemplatePattern: return "template-pattern";
+  case SkipReason::EnableIf:        return "enable-if";
+  case SkipReason::Instantiation:   return "instantiation";
+  }
+  return "unknown";
+}
+
+char const* phaseName(Phase phase) {
+  switch (phase) {
+  case Phase::Parse:    return "parse";
+  case Phase::Match:    return "match";
+  case Phase::Walk:     return "walk";
+  case Phase::TypeName: return "type-name";
+  case Phase::Output:   return "output";
+  }
+  return "unknown";
+}
+
+TUStats& TUStats::operator+=(TUStats const& other) {
+  for (std::size_t i = 0; i < num_phases; i++) {
+    wall_ns[i] += other.wall_ns[i];
+    cpu_ns[i] += other.cpu_ns[i];
+  }
+  for (std::size_t i = 0; i < num_skip_reasons; i++) {
+    skipped[i] += other.skipped[i];
+  }
+  total_ns += other.total_ns;
+  total_cpu_ns += other.total_cpu_ns;
+  records += other.records;
+  generated += other.generated;
+  members += other.members;
+  bytes += other.bytes;
+  return *this;
+}
+
+/*static*/ void PhaseTimer::begin(TUStats* stats) {
+  timer.stats = stats;
+  timer.depth = 0;
+  timer.start_wall = timer.last_wall = wallNow();
+  timer.start_cpu = timer.last_cpu = cpuNow();
+}
+
+/*static*/ void PhaseTimer::end() {
+  if (timer.stats == nullptr) {
+    return;
+  }
+  timer.charge();
+  timer.stats->total_ns += timer.last_wall - timer.start_wall;
+  timer.stats->total_cpu_ns += timer.last_cpu - timer.start_cpu;
+  timer.stats = nullptr;
+  timer.depth = 0;
+}
+
+/*static*/ void PhaseTimer::enter(Phase phase) {
+  if (timer.stats == nullptr) {
+    return;
+  }
+  timer.charge();
+  if (timer.depth < max_depth) {
+    timer.stack[timer.depth] = phase;
+  }
+  timer.depth++;
+}
+
+/*static*/ void PhaseTimer::leave() {
+  if (timer.stats == nullptr or timer.depth == 0) {
+    return;
+  }
+  timer.charge();
+  timer.depth--;
+}
+
+/*static*/ TUStats* PhaseTimer::current() {
+  return timer.stats;
+}
+
+} /* end namespace sanitizer */
@@ -0,0 +1,205 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                                phase_timer.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_PHASE_TIMER_H
+#define INCLUDED_SANITIZER_PHASE_TIMER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sanitizer {
+
+/// The phases the tool spends its time in for a translation unit
+enum struct Phase : std::size_t {
+  Parse = 0,  ///< Clang parsing the translation unit into an AST
+  Match,      ///< The record matcher, excluding the records it walks
+  Walk,       ///< WalkRecord walking matched records and generating code
+  TypeName,   ///< Printing fully qualified type names
+  Output      ///< Flushing rewritten files and writing the generated code
+};
+
+static constexpr std::size_t const num_phases = 5;
+
+/// Why a record was not generated
+enum struct SkipReason : std::size_t {
+  SystemHeader = 0, ///< Defined in a system header
+  NoSerialize,      ///< No serialize template taking one serializer
+  ExcludedPath,     ///< Defined in a file rejected by the path filter
+  TemplatePattern,  ///< A class template or a member of one, not instantiated
+  EnableIf,         ///< Its serialize takes extra template parameters
+  Instantiation     ///< A template instantiation, with -inline
+};
+
+static constexpr std::size_t const num_skip_reasons = 6;
+
+/**
+ * \brief Get the name of a skip reason
+ *
+ * \param[in] reason the reason
+ *
+ * \return the name
+ */
+char const* skipReasonName(SkipReason reason);
+
+/**
+ * \brief Get the name of a phase
+ *
+ * \param[in] phase the phase
+ *
+ * \return the name
+ */
+char const* phaseName(Phase phase);
+
+/**
+ * \struct TUStats
+ *
+ * \brief Time spent in each phase and work done for one translation unit
+ */
+struct TUStats {
+  /// Wall and CPU time of each phase in nanoseconds; nested phases are
+  /// excluded
+  std::array<uint64_t, num_phases> wall_ns = {};
+  std::array<uint64_t, num_phases> cpu_ns = {};
+  /// Wall and CPU time of the whole translation unit in nanoseconds
+  uint64_t total_ns = 0;
+  uint64_t total_cpu_ns = 0;
+  /// Records matched in the translation unit
+  std::size_t records = 0;
+  /// Records code was generated for
+  std::size_t generated = 0;
+  /// Records not generated, by reason
+  std::array<std::size_t, num_skip_reasons> skipped = {};
+  /// Members checks were generated for
+  std::size_t members = 0;
+  /// Bytes of generated code
+  std::size_t bytes = 0;
+
+  TUStats& operator+=(TUStats const& other);
+};
+
+/**
+ * \struct PhaseTimer
+ *
+ * \brief Attributes the wall and CPU time of the calling thread to the
+ * innermost phase entered. Timing is off until \c begin is called on the thread, so the
+ * phase scopes cost one thread-local load when statistics are disabled.
+ */
+struct PhaseTimer {
+
+  /**
+   * \brief Start timing a translation unit on the calling thread
+   *
+   * \param[in] stats where the times are accumulated
+   */
+  static void begin(TUStats* stats);
+
+  /**
+   * \brief Stop timing on the calling thread, charging any phase still
+   * entered (e.g., parsing that failed) up to now
+   */
+  static void end();
+
+  /**
+   * \brief Enter a phase, pausing the enclosing one
+   *
+   * \param[in] phase the phase
+   */
+  static void enter(Phase phase);
+
+  /**
+   * \brief Leave the innermost phase, resuming the enclosing one
+   */
+  static void leave();
+
+  /**
+   * \brief Get the statistics of the translation unit being timed on the
+   * calling thread
+   *
+   * \return the statistics or \c nullptr when timing is off
+   */
+  static TUStats* current();
+};
+
+/**
+ * \brief Count a record that was not generated in the translation unit
+ * being timed on the calling thread, if any
+ *
+ * \param[in] reason why the record was skipped
+ */
+inline void countSkipped(SkipReason reason) {
+  if (auto stats = PhaseTimer::current()) {
+    stats->skipped[static_cast<std::size_t>(reason)]++;
+  }
+}
+
+/**
+ * \brief Count a record code was generated for, in the translation unit
+ * being timed on the calling thread, if any
+ *
+ * \param[in] members the number of members checked
+ */
+inline void countGenerated(std::size_t members) {
+  if (auto stats = PhaseTimer::current()) {
+    stats->generated++;
+    stats->members += members;
+  }
+}
+
+/**
+ * \struct ScopedPhase
+ *
+ * \brief Enters a phase for the lifetime of the object
+ */
+struct ScopedPhase {
+  explicit ScopedPhase(Phase phase) { PhaseTimer::enter(phase); }
+  ~ScopedPhase() { PhaseTimer::leave(); }
+
+  ScopedPhase(ScopedPhase const&) = delete;
+  ScopedPhase& operator=(ScopedPhase const&) = delete;
+};
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_PHASE_TIMER_H*/
@@ -0,0 +1,265 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               prefix_header.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "common.h"
+#include "prefix_header.h"
+#include "analysis_cache.h"
+#include "database.h"
+
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace sanitizer {
+
+PrefixHeader::PrefixHeader(
+  std::string const& in_header, std::string const& in_dir
+) {
+  llvm::SmallString<256> header{in_header};
+  llvm::sys::fs::make_absolute(header);
+  header_ = header.str().str();
+
+  llvm::SmallString<256> dir{in_dir};
+  llvm::sys::fs::make_absolute(dir);
+  dir_ = dir.str().str();
+}
+
+/*static*/ std::vector<std::string> PrefixHeader::strip(
+  clang::tooling::CompileCommand const& cmd
+) {
+  auto const file = absolutePath(cmd.Directory, cmd.Filename);
+
+  std::vector<std::string> args;
+  auto const& in = cmd.CommandLine;
+  for (std::size_t i = 0; i < in.size(); i++) {
+    auto const& a = in[i];
+    // drop the output and dependency file flags with their values
+    if (a == "-o" or a == "-MF" or a == "-MT" or a == "-MQ") {
+      i++;
+      continue;
+    }
+    if (a == "-c" or a == "-MD" or a == "-MMD") {
+      continue;
+    }
+    // drop the input file
+    if (i > 0 and absolutePath(cmd.Directory, a) == file) {
+      continue;
+    }
+    args.push_back(a);
+  }
+  return args;
+}
+
+/*static*/ HashType PrefixHeader::signature(
+  clang::tooling::CompileCommand const& cmd,
+  std::vector<std::string> const& extra
+) {
+  auto h = hashBytes(cmd.Directory);
+  for (auto&& a : strip(cmd)) {
+    h = hashBytes(a, h);
+  }
+  for (auto&& a : extra) {
+    h = hashBytes(a, h);
+  }
+  return h;
+}
+
+std::string PrefixHeader::path(HashType sig, char const* ext) const {
+  return fmt::format(
+    "{}/{}.{}.{}", dir_, llvm::sys::path::filename(header_).str(),
+    hashString(sig), ext
+  );
+}
+
+/*
+ * The stamp lists every file the PCH read with its content hash, one
+ * "<hash> <path>" per line
+ */
+bool PrefixHeader::upToDate(
+  HashType sig, std::vector<std::string>& deps
+) const {
+  if (not llvm::sys::fs::exists(path(sig, "pch"))) {
+    return false;
+  }
+  auto buf = llvm::MemoryBuffer::getFile(path(sig, "stamp"));
+  if (not buf) {
+    return false;
+  }
+
+  llvm::SmallVector<llvm::StringRef, 64> lines;
+  (*buf)->getBuffer().split(lines, '\n', -1, false);
+  if (lines.empty()) {
+    return false;
+  }
+  for (auto&& l : lines) {
+    HashType expected = 0, actual = 0;
+    if (
+      l.size() < 18 or l.substr(0, 16).getAsInteger(16, expected) or
+      not AnalysisCache::hashFile(l.substr(17).str(), actual) or
+      actual != expected
+    ) {
+      return false;
+    }
+    deps.push_back(l.substr(17).str());
+  }
+  return true;
+}
+
+namespace {
+
+// Generate the PCH, recording every file it read for the stamp
+struct StampedPCHAction : clang::GeneratePCHAction {
+  explicit StampedPCHAction(std::vector<std::string>& in_deps)
+    : deps_(in_deps)
+  { }
+
+  void EndSourceFileAction() override {
+    auto& sm = getCompilerInstance().getSourceManager();
+    for (auto iter = sm.fileinfo_begin(); iter != sm.fileinfo_end(); ++iter) {
+      llvm::SmallString<256> path{iter->first->getName()};
+      sm.getFileManager().makeAbsolutePath(path);
+      deps_.push_back(path.str().str());
+    }
+    clang::GeneratePCHAction::EndSourceFileAction();
+  }
+
+private:
+  std::vector<std::string>& deps_;
+};
+
+} /* end anonymous namespace */
+
+bool PrefixHeader::prepare(
+  clang::tooling::CompileCommand const& cmd,
+  std::vector<std::string> const& extra
+) {
+  auto const sig = signature(cmd, extra);
+  auto const pch = path(sig, "pch");
+
+  std::vector<std::string> deps;
+  if (upToDate(sig, deps)) {
+    std::lock_guard<std::mutex> guard{mutex_};
+    pchs_[sig] = pch;
+    deps_[sig] = std::move(deps);
+    reused_++;
+    return true;
+  }
+  deps.clear();
+
+  if (auto ec = llvm::sys::fs::create_directories(dir_)) {
+    fmt::print(stderr, "Could not create {}: {}\n", dir_, ec.message());
+    return false;
+  }
+
+  // The flags of the group, with the header as the input
+  auto args = strip(cmd);
+  args.insert(args.end(), extra.begin(), extra.end());
+  args.insert(
+    args.begin() + 1, {"-working-directory", cmd.Directory}
+  );
+  args.insert(args.end(), {"-x", "c++-header", header_, "-o", pch});
+
+  llvm::IntrusiveRefCntPtr<clang::FileManager> files{
+    new clang::FileManager(clang::FileSystemOptions{})
+  };
+  clang::tooling::ToolInvocation invocation{
+    args, new StampedPCHAction(deps), files.get()
+  };
+  if (not invocation.run()) {
+    fmt::print(stderr, "Could not precompile {} for {}\n", header_, cmd.Filename);
+    return false;
+  }
+
+  fmt::memory_buffer stamp;
+  for (auto&& d : deps) {
+    HashType h = 0;
+    if (AnalysisCache::hashFile(d, h)) {
+      fmt::format_to(stamp, "{} {}\n", hashString(h), d);
+    }
+  }
+  std::error_code ec;
+  llvm::raw_fd_ostream os{path(sig, "stamp"), ec, llvm::sys::fs::F_None};
+  if (not ec) {
+    os << fmt::to_string(stamp);
+  }
+
+  std::lock_guard<std::mutex> guard{mutex_};
+  pchs_[sig] = pch;
+  deps_[sig] = std::move(deps);
+  built_++;
+  return true;
+}
+
+std::string PrefixHeader::pchFor(
+  clang::tooling::CompileCommand const& cmd,
+  std::vector<std::string> const& extra
+) const {
+  std::lock_guard<std::mutex> guard{mutex_};
+  auto iter = pchs_.find(signature(cmd, extra));
+  return iter == pchs_.end() ? "" : iter->second;
+}
+
+std::vector<std::string> PrefixHeader::dependencies(
+  clang::tooling::CompileCommand const& cmd,
+  std::vector<std::string> const& extra
+) const {
+  auto const sig = signature(cmd, extra);
+  std::lock_guard<std::mutex> guard{mutex_};
+  auto iter = deps_.find(sig);
+  if (iter == deps_.end()) {
+    return {};
+  }
+
+  std::vector<std::string> deps{path(sig, "pch"), path(sig, "stamp")};
+  deps.insert(deps.end(), iter->second.begin(), iter->second.end());
+  return deps;
+}
+
+} /* end namespace sanitizer */
@@ -0,0 +1,156 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               prefix_header.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_PREFIX_HEADER_H
+#define INCLUDED_SANITIZER_PREFIX_HEADER_H
+
+#include "common.h"
+#include "hash.h"
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sanitizer {
+
+/**
+ * \struct PrefixHeader
+ *
+ * \brief Precompiles a header that every translation unit includes, so its
+ * contents are parsed once instead of once per translation unit.
+ *
+ * A PCH is only usable by translation units compiled with the same flags, so
+ * translation units are grouped by the signature of their compile command
+ * (without the input and output files) and one PCH is built per group. A PCH
+ * is rebuilt only when its flags or any file it read changed since it was
+ * built, which is recorded in a stamp file next to it.
+ */
+struct PrefixHeader {
+
+  PrefixHeader(std::string const& in_header, std::string const& in_dir);
+
+  /**
+   * \brief Compute the signature of a compile command's flags
+   *
+   * \param[in] cmd the compile command
+   * \param[in] extra extra arguments appended by the tool
+   *
+   * \return the signature
+   */
+  static HashType signature(
+    clang::tooling::CompileCommand const& cmd,
+    std::vector<std::string> const& extra
+  );
+
+  /**
+   * \brief Build (or reuse) the PCH for the group of a compile command
+   *
+   * \param[in] cmd a compile command of the group
+   * \param[in] extra extra arguments appended by the tool
+   *
+   * \return whether a PCH is available for the group
+   */
+  bool prepare(
+    clang::tooling::CompileCommand const& cmd,
+    std::vector<std::string> const& extra
+  );
+
+  /**
+   * \brief Get the PCH for a compile command
+   *
+   * \param[in] cmd the compile command
+   * \param[in] extra extra arguments appended by the tool
+   *
+   * \return the path of the PCH or empty when there is none for its group
+   */
+  std::string pchFor(
+    clang::tooling::CompileCommand const& cmd,
+    std::vector<std::string> const& extra
+  ) const;
+
+  /**
+   * \brief Get the files that a translation unit using the PCH for a compile
+   * command depends on through it: the PCH, its stamp and every file the PCH
+   * was built from
+   *
+   * \param[in] cmd the compile command
+   * \param[in] extra extra arguments appended by the tool
+   *
+   * \return the paths of the files or empty when there is no PCH for its group
+   */
+  std::vector<std::string> dependencies(
+    clang::tooling::CompileCommand const& cmd,
+    std::vector<std::string> const& extra
+  ) const;
+
+  std::size_t numBuilt() const { return built_; }
+  std::size_t numReused() const { return reused_; }
+
+private:
+  static std::vector<std::string> strip(
+    clang::tooling::CompileCommand const& cmd
+  );
+
+  std::string path(HashType sig, char const* ext) const;
+
+  bool upToDate(HashType sig, std::vector<std::string>& deps) const;
+
+private:
+  std::string header_;
+  std::string dir_;
+  mutable std::mutex mutex_;
+  /// PCH path by signature for the groups that have one
+  std::map<HashType, std::string> pchs_;
+  /// Files each PCH was built from by signature
+  std::map<HashType, std::vector<std::string>> deps_;
+  std::size_t built_ = 0;
+  std::size_t reused_ = 0;
+};
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_PREFIX_HEADER_H*/
@@ -0,0 +1,142 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                              record_matcher.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "common.h"
+#include "record_matcher.h"
+#include "phase_timer.h"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/SourceManager.h"
+
+namespace sanitizer {
+
+PathFilter::PathFilter(
+  std::vector<std::string> const& in_include,
+  std::vector<std::string> const& in_exclude
+) {
+  for (auto&& r : in_include) {
+    include_.emplace_back(r);
+  }
+  for (auto&& r : in_exclude) {
+    exclude_.emplace_back(r);
+  }
+}
+
+bool PathFilter::isValid(std::string& error) const {
+  for (auto&& r : include_) {
+    if (not r.isValid(error)) {
+      return false;
+    }
+  }
+  for (auto&& r : exclude_) {
+    if (not r.isValid(error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PathFilter::matches(llvm::StringRef path, bool main_file) const {
+  for (auto&& r : exclude_) {
+    if (r.match(path)) {
+      return false;
+    }
+  }
+  if (include_.empty() or main_file) {
+    return true;
+  }
+  for (auto&& r : include_) {
+    if (r.match(path)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace {
+
+using namespace clang::ast_matchers;
+
+AST_MATCHER_P(clang::Decl, isInSelectedPath, PathFilter const*, filter) {
+  if (filter == nullptr) {
+    return true;
+  }
+  auto const& sm = Finder->getASTContext().getSourceManager();
+  auto const loc = sm.getExpansionLoc(Node.getLocation());
+  return filter->matches(sm.getFilename(loc), sm.isInMainFile(loc));
+}
+
+// Match with an inner matcher, counting the records it rejects for -stats
+AST_MATCHER_P2(
+  clang::Decl, countRejected,
+  clang::ast_matchers::internal::Matcher<clang::Decl>, inner,
+  SkipReason, reason
+) {
+  if (inner.matches(Node, Finder, Builder)) {
+    return true;
+  }
+  countSkipped(reason);
+  return false;
+}
+
+} /* end anonymous namespace */
+
+clang::ast_matchers::DeclarationMatcher makeRecordMatcher(
+  PathFilter const* filter
+) {
+  using namespace clang::ast_matchers;
+
+  return cxxRecordDecl(
+    isDefinition(),
+    countRejected(
+      unless(isExpansionInSystemHeader()), SkipReason::SystemHeader
+    ),
+    countRejected(
+      has(functionTemplateDecl(hasName("serialize"))), SkipReason::NoSerialize
+    ),
+    countRejected(isInSelectedPath(filter), SkipReason::ExcludedPath)
+  ).bind("recordDecl");
+}
+
+} /* end namespace sanitizer */
@@ -0,0 +1,115 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               record_matcher.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_RECORD_MATCHER_H
+#define INCLUDED_SANITIZER_RECORD_MATCHER_H
+
+#include "common.h"
+
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/Support/Regex.h"
+
+#include <string>
+#include <vector>
+
+namespace sanitizer {
+
+/**
+ * \struct PathFilter
+ *
+ * \brief Selects records by the path of the file that defines them. A record
+ * is selected unless its file matches an exclude regex; when include regexes
+ * are given, records outside the main file must also match one of them.
+ */
+struct PathFilter {
+
+  PathFilter(
+    std::vector<std::string> const& in_include,
+    std::vector<std::string> const& in_exclude
+  );
+
+  /**
+   * \brief Check that all the regular expressions are valid
+   *
+   * \param[out] error the error message when invalid
+   *
+   * \return whether they are valid
+   */
+  bool isValid(std::string& error) const;
+
+  /**
+   * \brief Whether a record in a file is selected
+   *
+   * \param[in] path the path of the defining file
+   * \param[in] main_file whether the file is the main file of the TU
+   *
+   * \return whether it is selected
+   */
+  bool matches(llvm::StringRef path, bool main_file) const;
+
+private:
+  // llvm::Regex::match is not const before LLVM 10
+  mutable std::vector<llvm::Regex> include_;
+  mutable std::vector<llvm::Regex> exclude_;
+};
+
+/**
+ * \brief Build the matcher for records to generate code for: definitions
+ * outside system headers with a member function template named \c serialize
+ * in a file selected by the path filter. The cheap conditions are checked
+ * first so most records are rejected before the path is looked at. Records
+ * rejected for any but the first condition are counted in the statistics of
+ * the translation unit, when enabled.
+ *
+ * \param[in] filter the path filter, which must outlive the matcher
+ *
+ * \return the matcher, bound to \c "recordDecl"
+ */
+clang::ast_matchers::DeclarationMatcher makeRecordMatcher(
+  PathFilter const* filter
+);
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_RECORD_MATCHER_H*/
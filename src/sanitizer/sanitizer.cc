@@ -48,6 +48,11 @@
 #include "clang/Tooling/Tooling.h"
 // Declares llvm::cl::extrahelp.
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Config/llvm-config.h"
+#if LLVM_VERSION_MAJOR > 7
+#include "llvm/Support/VirtualFileSystem.h"
+#endif
 
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
@@ -55,11 +60,26 @@
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Frontend/CompilerInstance.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include <fmt/format.h>
 
+#include "analysis_cache.h"
+#include "database.h"
 #include "generator.h"
+#include "phase_timer.h"
+#include "prefix_header.h"
+#include "record_matcher.h"
+#include "shared_records.h"
 #include "walk_record.h"
 
 using namespace clang;
@@ -67,28 +87,129 @@ using namespace llvm;
 using namespace clang::tooling;
 using namespace clang::ast_matchers;
 
-static FILE* out = nullptr;
-
 static cl::opt<std::string> Filename("o", cl::desc("Filename to output generated code"));
 static cl::list<std::string> Includes("I", cl::desc("Include directories"), cl::ZeroOrMore);
 static cl::opt<bool> GenerateInline("inline", cl::desc("Generate code inline and modify files"));
+static cl::opt<bool> GenerateLayout("layout", cl::desc("Generate a compile-time member layout table per class checked with one call"));
 static cl::opt<bool> OutputMainFile("include-input", cl::desc("Output input file with generated code"));
 static cl::opt<bool> IncludeVTHeader("Ivt", cl::desc("Include VT headers in generated code"));
+static cl::opt<bool> InPlace("in-place", cl::desc("Replace each input file with itself and its generated code, keeping a .bak backup"));
+static cl::opt<unsigned> Jobs("j", cl::desc("Number of translation units to process in parallel (0 for all cores)"), cl::init(1));
+static cl::opt<std::string> DirMatch("dir-match", cl::desc("Only process compile commands whose directory matches this regex"));
+static cl::opt<std::string> FileMatch("file-match", cl::desc("Only process files that match this regex"));
+static cl::opt<std::string> IgnoreMatch("ignore", cl::desc("Skip files that match this regex"));
+static cl::list<std::string> IncludePaths("include-path", cl::desc("Only generate code for records in files that match one of these regexes (records in the main file are always included)"), cl::ZeroOrMore);
+static cl::list<std::string> ExcludePaths("exclude-path", cl::desc("Never generate code for records in files that match one of these regexes"), cl::ZeroOrMore);
+static cl::opt<std::string> PCHHeader("pch-header", cl::desc("Precompile this header, included by every translation unit, once per set of compile flags"));
+static cl::opt<std::string> PCHDir("pch-dir", cl::desc("Directory for the precompiled headers"), cl::init(".sanitizer-pch"));
+static cl::opt<std::string> CacheDir("cache-dir", cl::desc("Directory of the persistent analysis cache reused across runs"));
+static cl::opt<bool> Stats("stats", cl::desc("Print the wall and CPU time of each phase, records generated and skipped by reason, members checked and bytes generated"));
+static cl::opt<std::string> StatsJSON("stats-json", cl::desc("Write the time spent in each phase, records and bytes generated per translation unit as JSON to this file"));
+static cl::opt<std::string> SharedDir("shared-dir", cl::desc("Generate records defined in headers once, into per-header files in this directory included by each translation unit"));
+
+// Records shared across translation units when -shared-dir is given
+static std::unique_ptr<sanitizer::SharedRecords> shared_records = nullptr;
+
+// Persistent analysis cache when -cache-dir is given (not used with -inline)
+static std::unique_ptr<sanitizer::AnalysisCache> analysis_cache = nullptr;
+
+// Precompiled prefix header when -pch-header is given
+static std::unique_ptr<sanitizer::PrefixHeader> prefix_header = nullptr;
+
+// The output of one translation unit
+struct TUOutput {
+  /// The generated code (preceded by the input file with -include-input)
+  fmt::memory_buffer code;
+  /// Size of the code that precedes the output of the tool
+  std::size_t prefix = 0;
+  /// Size of the code generated for each record, in order after the prefix,
+  /// so records repeated across TUs written to one output are written once
+  std::vector<std::size_t> records;
+  /// The shared records seen in the translation unit
+  std::vector<sanitizer::RecordKey> shared;
+  /// The files read by the translation unit, for the analysis cache
+  std::vector<std::string> deps;
+  /// Cache key of the translation unit
+  sanitizer::HashType key = 0;
+  /// Whether the output came from the analysis cache
+  bool cached = false;
+  /// Whether the tool failed on the translation unit
+  bool failed = false;
+  /// Phase times and counters, with -stats or -stats-json
+  sanitizer::TUStats stats;
+};
 
-DeclarationMatcher RecordMatcher = cxxRecordDecl().bind("recordDecl");
+// Selects records by defining file from -include-path and -exclude-path
+static std::unique_ptr<sanitizer::PathFilter> path_filter = nullptr;
 
 struct ClassFuncDeclRewriter : MatchFinder::MatchCallback {
-  explicit ClassFuncDeclRewriter(Rewriter& in_rw)
-    : rw(in_rw)
+  ClassFuncDeclRewriter(Rewriter& in_rw, TUOutput& in_out)
+    : rw(in_rw),
+      out(in_out)
   { }
 
   virtual void run(MatchFinder::MatchResult const& result) {
+    out.stats.records++;
+
+    // Records defined in headers are analyzed and generated once across TUs
+    sanitizer::RecordKey key;
+    if (
+      shared_records != nullptr and not GenerateInline and
+      sanitizer::RecordKey::make(
+        result.Nodes.getNodeAs<CXXRecordDecl>("recordDecl"), key
+      )
+    ) {
+      out.shared.push_back(key);
+      if (shared_records->claim(key)) {
+        fmt::memory_buffer buf;
+        generate(result, buf);
+        shared_records->emit(key, fmt::to_string(buf));
+      }
+      return;
+    }
+
+    auto const begin = out.code.size();
+    generate(result, out.code);
+    out.records.push_back(out.code.size() - begin);
+  }
+
+private:
+  // Generate through the record-level analysis cache when enabled
+  void generate(MatchFinder::MatchResult const& result, fmt::memory_buffer& buf) {
+    sanitizer::HashType key = 0;
+    if (
+      analysis_cache == nullptr or
+      not sanitizer::AnalysisCache::recordKey(
+        result.Nodes.getNodeAs<CXXRecordDecl>("recordDecl"), file_hashes, key
+      )
+    ) {
+      walk(result, buf);
+      return;
+    }
+    if (GenerateLayout) {
+      key = sanitizer::hashBytes("layout", key);
+    }
+
+    std::string code;
+    if (not analysis_cache->lookupRecord(key, code)) {
+      fmt::memory_buffer gen;
+      walk(result, gen);
+      code = fmt::to_string(gen);
+      analysis_cache->storeRecord(key, code);
+    }
+    buf.append(code.data(), code.data() + code.size());
+  }
+
+  void walk(MatchFinder::MatchResult const& result, fmt::memory_buffer& buf) {
+    sanitizer::ScopedPhase phase{sanitizer::Phase::Walk};
     std::unique_ptr<sanitizer::Generator> gen = nullptr;
 
     if (GenerateInline) {
       gen = std::make_unique<sanitizer::InlineGenerator>(rw);
+    } else if (GenerateLayout) {
+      gen = std::make_unique<sanitizer::LayoutGenerator>(buf);
     } else {
-      gen = std::make_unique<sanitizer::PartialSpecializationGenerator>(out);
+      gen = std::make_unique<sanitizer::PartialSpecializationGenerator>(buf);
     }
 
     auto t = std::make_unique<sanitizer::WalkRecord>(GenerateInline, std::move(gen));
@@ -97,15 +218,26 @@ struct ClassFuncDeclRewriter : MatchFinder::MatchCallback {
 
 private:
   Rewriter& rw;
+  TUOutput& out;
+  /// File hashes for the record-level cache keys of this TU
+  sanitizer::FileHashMemo file_hashes;
 };
 
 struct MyASTConsumer : ASTConsumer {
-  MyASTConsumer(Rewriter& in_rw) : record_handler(in_rw) {
-    matcher_.addMatcher(RecordMatcher, &record_handler);
+  MyASTConsumer(Rewriter& in_rw, TUOutput& in_out)
+    : record_handler(in_rw, in_out)
+  {
+    matcher_.addMatcher(
+      sanitizer::makeRecordMatcher(path_filter.get()), &record_handler
+    );
   }
 
   void HandleTranslationUnit(ASTContext& Context) override {
+    // Parsing entered when the consumer was created is done
+    sanitizer::PhaseTimer::leave();
+
     // Run the matchers when we have the whole TU parsed.
+    sanitizer::ScopedPhase phase{sanitizer::Phase::Match};
     matcher_.matchAST(Context);
   }
 
@@ -115,8 +247,15 @@ private:
 };
 
 // For each source file provided to the tool, a new FrontendAction is created.
+// The generated code goes to the output buffer of the translation unit.
 struct MyFrontendAction : ASTFrontendAction {
+  explicit MyFrontendAction(TUOutput& in_out)
+    : out_(in_out)
+  { }
+
   void EndSourceFileAction() override {
+    sanitizer::ScopedPhase phase{sanitizer::Phase::Output};
+
     //rw_.getEditBuffer(rw_.getSourceMgr().getMainFileID()).write(llvm::outs());
     //rw_.getSourceMgr().getMainFileID()
 
@@ -129,6 +268,15 @@ struct MyFrontendAction : ASTFrontendAction {
     }
 
     rw_.overwriteChangedFiles();
+
+    // Record every file the translation unit read for the analysis cache
+    if (analysis_cache != nullptr) {
+      for (auto iter = sm.fileinfo_begin(); iter != sm.fileinfo_end(); ++iter) {
+        llvm::SmallString<256> path{iter->first->getName()};
+        sm.getFileManager().makeAbsolutePath(path);
+        out_.deps.push_back(path.str().str());
+      }
+    }
   }
 
   std::unique_ptr<ASTConsumer>
@@ -137,16 +285,363 @@ struct MyFrontendAction : ASTFrontendAction {
 
     if (OutputMainFile) {
       auto buf = rw_.getSourceMgr().getBufferData(rw_.getSourceMgr().getMainFileID());
-      fmt::print(out, "{}", buf.str());
+      out_.code.append(buf.begin(), buf.end());
     }
 
-    return llvm::make_unique<MyASTConsumer>(rw_);
+    sanitizer::PhaseTimer::enter(sanitizer::Phase::Parse);
+    return llvm::make_unique<MyASTConsumer>(rw_, out_);
   }
 
 private:
   Rewriter rw_;
+  TUOutput& out_;
+};
+
+struct MyFrontendActionFactory : FrontendActionFactory {
+  explicit MyFrontendActionFactory(TUOutput& in_out)
+    : out_(in_out)
+  { }
+
+  FrontendAction* create() override {
+    return new MyFrontendAction(out_);
+  }
+
+private:
+  TUOutput& out_;
 };
 
+// The arguments the tool appends to every compile command
+static std::vector<std::string> extraArguments() {
+  std::vector<std::string> args;
+  for (auto&& e : Includes) {
+    args.push_back(std::string("-I") + e);
+  }
+  return args;
+}
+
+// Run a function for each index, on a thread pool when there are many jobs
+static void runJobs(
+  std::size_t n, unsigned jobs, std::function<void(std::size_t)> fn
+) {
+  if (jobs <= 1) {
+    for (std::size_t i = 0; i < n; i++) {
+      fn(i);
+    }
+  } else {
+    ThreadPool pool(jobs);
+    for (std::size_t i = 0; i < n; i++) {
+      pool.async([&fn, i]{ fn(i); });
+    }
+    pool.wait();
+  }
+}
+
+// Precompile the prefix header for every set of compile flags shared by at
+// least two translation units
+static void preparePrefixHeader(
+  CompilationDatabase const& db, std::vector<std::string> const& files,
+  unsigned jobs
+) {
+  auto const extra = extraArguments();
+  std::map<sanitizer::HashType, std::vector<CompileCommand>> groups;
+  for (auto&& f : files) {
+    auto const cmds = db.getCompileCommands(f);
+    if (not cmds.empty()) {
+      groups[sanitizer::PrefixHeader::signature(cmds.front(), extra)].push_back(
+        cmds.front()
+      );
+    }
+  }
+
+  std::vector<CompileCommand> group_cmds;
+  for (auto&& g : groups) {
+    if (g.second.size() > 1) {
+      group_cmds.push_back(g.second.front());
+    }
+  }
+
+  runJobs(group_cmds.size(), jobs, [&](std::size_t i) {
+    prefix_header->prepare(group_cmds[i], extra);
+  });
+
+  fmt::print(
+    stderr, "Precompiled {} for {} of {} flag sets: {} built, {} reused\n",
+    PCHHeader, prefix_header->numBuilt() + prefix_header->numReused(),
+    groups.size(), prefix_header->numBuilt(), prefix_header->numReused()
+  );
+}
+
+// Key a translation unit by its file, compile command and the options that
+// change its output
+static sanitizer::HashType translationUnitKey(
+  CompilationDatabase const& db, std::string const& file
+) {
+  auto h = sanitizer::hashBytes(file);
+  for (auto&& cmd : db.getCompileCommands(file)) {
+    h = sanitizer::hashBytes(cmd.Directory, h);
+    for (auto&& arg : cmd.CommandLine) {
+      h = sanitizer::hashBytes(arg, h);
+    }
+  }
+  for (auto&& e : Includes) {
+    h = sanitizer::hashBytes(e, h);
+  }
+  for (auto&& p : IncludePaths) {
+    h = sanitizer::hashBytes("include-path=" + p, h);
+  }
+  for (auto&& p : ExcludePaths) {
+    h = sanitizer::hashBytes("exclude-path=" + p, h);
+  }
+  auto const options = fmt::format(
+    "include-input={} shared={} layout={}", OutputMainFile, SharedDir != "",
+    GenerateLayout
+  );
+  return sanitizer::hashBytes(options, h);
+}
+
+// Reuse the output of a translation unit whose files did not change
+static bool reuseTranslationUnit(TUOutput& out) {
+  sanitizer::CachedTU tu;
+  if (not analysis_cache->lookupTU(out.key, tu)) {
+    return false;
+  }
+
+  out.code.append(tu.code.data(), tu.code.data() + tu.code.size());
+  out.records = tu.records;
+  for (auto&& s : tu.shared) {
+    // another TU may already have generated the record in this run
+    if (shared_records != nullptr and shared_records->claim(s.key)) {
+      shared_records->emit(s.key, s.code);
+    }
+    out.shared.push_back(s.key);
+  }
+  out.cached = true;
+  return true;
+}
+
+// Store a translation unit that was processed in the analysis cache
+static void storeTranslationUnit(TUOutput const& out) {
+  sanitizer::CachedTU tu;
+  for (auto&& d : out.deps) {
+    sanitizer::HashType h = 0;
+    if (not sanitizer::AnalysisCache::hashFile(d, h)) {
+      return;
+    }
+    tu.deps.emplace_back(d, h);
+  }
+  for (auto&& s : out.shared) {
+    tu.shared.push_back(
+      sanitizer::CachedSharedRecord{s, shared_records->codeFor(s)}
+    );
+  }
+  tu.code.assign(out.code.data() + out.prefix, out.code.size() - out.prefix);
+  tu.records = out.records;
+  analysis_cache->storeTU(out.key, tu);
+}
+
+// Run the tool over one translation unit, appending to its output
+static int runTranslationUnit(
+  CompilationDatabase const& db, std::string const& file, TUOutput& out
+) {
+  if (analysis_cache != nullptr) {
+    out.key = translationUnitKey(db, file);
+    if (reuseTranslationUnit(out)) {
+      return 0;
+    }
+  }
+
+#if LLVM_VERSION_MAJOR > 7
+  // Give each tool its own working directory instead of changing the
+  // process-wide one, so translation units can be processed concurrently
+  ClangTool Tool(
+    db, {file}, std::make_shared<PCHContainerOperations>(),
+    llvm::vfs::createPhysicalFileSystem().release()
+  );
+#else
+  ClangTool Tool(db, {file});
+#endif
+
+  for (auto&& e : Includes) {
+    auto str = std::string("-I") + e;
+    ArgumentsAdjuster ad1 = getInsertArgumentAdjuster(str.c_str());
+    Tool.appendArgumentsAdjuster(ad1);
+  }
+
+  if (prefix_header != nullptr) {
+    auto const cmds = db.getCompileCommands(file);
+    auto const pch = cmds.empty() ?
+      "" : prefix_header->pchFor(cmds.front(), extraArguments());
+    if (pch != "" and analysis_cache != nullptr) {
+      // the headers in the PCH are not read again by the translation unit
+      auto const deps = prefix_header->dependencies(cmds.front(), extraArguments());
+      out.deps.insert(out.deps.end(), deps.begin(), deps.end());
+    }
+    if (pch != "") {
+      Tool.appendArgumentsAdjuster(
+        getInsertArgumentAdjuster(
+          CommandLineArguments{"-include-pch", pch},
+          ArgumentInsertPosition::BEGIN
+        )
+      );
+    }
+  }
+
+  MyFrontendActionFactory factory{out};
+  return Tool.run(&factory);
+}
+
+static bool statsEnabled() {
+  return Stats or StatsJSON != "";
+}
+
+// Run the tool over one translation unit, timing its phases with -stats
+static int processTranslationUnit(
+  CompilationDatabase const& db, std::string const& file, TUOutput& out
+) {
+  if (statsEnabled()) {
+    sanitizer::PhaseTimer::begin(&out.stats);
+  }
+  auto const ret = runTranslationUnit(db, file, out);
+  sanitizer::PhaseTimer::end();
+  return ret;
+}
+
+static std::string jsonString(std::string const& str) {
+  std::string out = "\"";
+  for (auto c : str) {
+    if (c == '"' or c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+static void formatStats(
+  fmt::memory_buffer& buf, sanitizer::TUStats const& stats, char const* indent
+) {
+  fmt::format_to(
+    buf, "{0}\"total_ns\": {1},\n{0}\"total_cpu_ns\": {2},\n"
+    "{0}\"records\": {3},\n{0}\"generated\": {4},\n{0}\"members\": {5},\n"
+    "{0}\"bytes\": {6},\n", indent, stats.total_ns, stats.total_cpu_ns,
+    stats.records, stats.generated, stats.members, stats.bytes
+  );
+  fmt::format_to(buf, "{}\"skipped\": {{", indent);
+  for (std::size_t i = 0; i < sanitizer::num_skip_reasons; i++) {
+    fmt::format_to(
+      buf, "{}\"{}\": {}", i > 0 ? ", " : " ",
+      sanitizer::skipReasonName(static_cast<sanitizer::SkipReason>(i)),
+      stats.skipped[i]
+    );
+  }
+  fmt::format_to(buf, " }},\n");
+  auto phases = [&](char const* name, std::array<uint64_t, sanitizer::num_phases> const& ns) {
+    fmt::format_to(buf, "{}\"{}\": {{", indent, name);
+    for (std::size_t i = 0; i < sanitizer::num_phases; i++) {
+      fmt::format_to(
+        buf, "{}\"{}\": {}", i > 0 ? ", " : " ",
+        sanitizer::phaseName(static_cast<sanitizer::Phase>(i)), ns[i]
+      );
+    }
+  };
+  phases("phases_ns", stats.wall_ns);
+  fmt::format_to(buf, " }},\n");
+  phases("phases_cpu_ns", stats.cpu_ns);
+  fmt::format_to(buf, " }}\n");
+}
+
+// Print the statistics summed over all translation units
+static void printStats(
+  std::vector<TUOutput> const& outputs, unsigned jobs, uint64_t wall_ns
+) {
+  sanitizer::TUStats totals;
+  for (auto&& o : outputs) {
+    totals += o.stats;
+  }
+
+  // rounded to 0.1 ms up front: the bundled fmt may print tiny values with
+  // more digits than the precision asks for
+  auto ms = [](uint64_t ns) { return std::round(static_cast<double>(ns) * 1e-5) / 10; };
+  auto percent = [](uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / whole;
+  };
+
+  fmt::print(
+    stderr, "Statistics for {} translation units ({:.1f} ms wall with {} jobs):\n",
+    outputs.size(), ms(wall_ns), jobs
+  );
+  fmt::print(stderr, "  {:<12} {:>12} {:>12} {:>8}\n", "phase", "wall ms", "cpu ms", "wall %");
+  uint64_t phase_wall = 0, phase_cpu = 0;
+  for (std::size_t i = 0; i < sanitizer::num_phases; i++) {
+    phase_wall += totals.wall_ns[i];
+    phase_cpu += totals.cpu_ns[i];
+    fmt::print(
+      stderr, "  {:<12} {:>12.1f} {:>12.1f} {:>7.1f}%\n",
+      sanitizer::phaseName(static_cast<sanitizer::Phase>(i)),
+      ms(totals.wall_ns[i]), ms(totals.cpu_ns[i]),
+      percent(totals.wall_ns[i], totals.total_ns)
+    );
+  }
+  auto const other_wall = totals.total_ns - std::min(totals.total_ns, phase_wall);
+  auto const other_cpu = totals.total_cpu_ns - std::min(totals.total_cpu_ns, phase_cpu);
+  fmt::print(
+    stderr, "  {:<12} {:>12.1f} {:>12.1f} {:>7.1f}%\n", "other",
+    ms(other_wall), ms(other_cpu), percent(other_wall, totals.total_ns)
+  );
+  fmt::print(
+    stderr, "  {:<12} {:>12.1f} {:>12.1f}\n", "total",
+    ms(totals.total_ns), ms(totals.total_cpu_ns)
+  );
+
+  fmt::print(
+    stderr, "Records: {} matched, {} generated with {} members, {} bytes written\n",
+    totals.records, totals.generated, totals.members, totals.bytes
+  );
+  fmt::print(stderr, "Records skipped:");
+  for (std::size_t i = 0; i < sanitizer::num_skip_reasons; i++) {
+    fmt::print(
+      stderr, "{} {} {}", i > 0 ? "," : "",
+      sanitizer::skipReasonName(static_cast<sanitizer::SkipReason>(i)),
+      totals.skipped[i]
+    );
+  }
+  fmt::print(stderr, "\n");
+}
+
+// Write the statistics of every translation unit and their totals
+static bool writeStatsJSON(
+  std::vector<std::string> const& files, std::vector<TUOutput> const& outputs,
+  unsigned jobs, uint64_t wall_ns
+) {
+  fmt::memory_buffer buf;
+  sanitizer::TUStats totals;
+  fmt::format_to(
+    buf, "{{\n  \"jobs\": {},\n  \"wall_ns\": {},\n  \"translation_units\": [",
+    jobs, wall_ns
+  );
+  for (std::size_t i = 0; i < files.size(); i++) {
+    auto const& o = outputs[i];
+    totals += o.stats;
+    fmt::format_to(
+      buf, "{}\n    {{\n      \"file\": {},\n      \"failed\": {},\n"
+      "      \"cached\": {},\n", i > 0 ? "," : "", jsonString(files[i]),
+      o.failed, o.cached
+    );
+    formatStats(buf, o.stats, "      ");
+    fmt::format_to(buf, "    }}");
+  }
+  fmt::format_to(buf, "\n  ],\n  \"totals\": {{\n");
+  formatStats(buf, totals, "    ");
+  fmt::format_to(buf, "  }}\n}}\n");
+
+  auto out = fopen(StatsJSON.c_str(), "w");
+  if (out == nullptr) {
+    return false;
+  }
+  auto const ok = fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+  return fclose(out) == 0 and ok;
+}
+
 // Apply a custom category to all command-line options so that they are the
 // only ones displayed.
 static cl::OptionCategory SerializeCheckerCategory("Serialize sanitizer");
@@ -156,37 +651,206 @@ static cl::OptionCategory SerializeCheckerCategory("Serialize sanitizer");
 // It's nice to have this help message in all tools.
 static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
 
+// Write the output of a translation unit to the output shared by all of
+// them, skipping the code of records that an earlier one already wrote (a
+// record defined in a header is generated by every TU that includes it)
+static void writeSharedOutput(
+  FILE* out, TUOutput const& o, std::unordered_set<sanitizer::HashType>& written
+) {
+  llvm::StringRef const code{o.code.data(), o.code.size()};
+  auto const write = [out](llvm::StringRef str) {
+    fwrite(str.data(), 1, str.size(), out);
+  };
+
+  auto pos = o.prefix;
+  write(code.substr(0, pos));
+  for (auto&& len : o.records) {
+    auto const record = code.substr(pos, len);
+    if (written.insert(sanitizer::hashBytes(record)).second) {
+      write(record);
+    }
+    pos += len;
+  }
+  write(code.substr(pos));
+}
+
 // A help message for this specific tool can be added afterwards.
-static cl::extrahelp MoreHelp("\nGenerates sanitizer code for serializers\n");
+static cl::extrahelp MoreHelp(
+  "\nGenerates sanitizer code for serializers\n\n"
+  "Without source files, every file in the compilation database that passes\n"
+  "-dir-match, -file-match and -ignore is processed.\n"
+);
 
 int main(int argc, const char **argv) {
-  CommonOptionsParser OptionsParser(argc, argv, SerializeCheckerCategory);
+  CommonOptionsParser OptionsParser(
+    argc, argv, SerializeCheckerCategory, cl::ZeroOrMore
+  );
 
-  ClangTool Tool(
-    OptionsParser.getCompilations(), OptionsParser.getSourcePathList()
+  sanitizer::TUFilter filter{DirMatch, FileMatch, IgnoreMatch};
+  std::string error;
+  if (not filter.isValid(error)) {
+    fmt::print(stderr, "Invalid file filter: {}\n", error);
+    return 1;
+  }
+
+  path_filter = std::make_unique<sanitizer::PathFilter>(
+    std::vector<std::string>{IncludePaths.begin(), IncludePaths.end()},
+    std::vector<std::string>{ExcludePaths.begin(), ExcludePaths.end()}
+  );
+  if (not path_filter->isValid(error)) {
+    fmt::print(stderr, "Invalid path filter: {}\n", error);
+    return 1;
+  }
+
+  auto const& db = OptionsParser.getCompilations();
+  auto const files = sanitizer::selectTranslationUnits(
+    db, OptionsParser.getSourcePathList(), filter
   );
+  if (files.empty()) {
+    fmt::print(stderr, "No translation units selected\n");
+    return 1;
+  }
+
+  if (InPlace) {
+    if (Filename != "") {
+      fmt::print(stderr, "-in-place and -o are mutually exclusive\n");
+      return 1;
+    }
+    OutputMainFile = true;
+  } else if (OutputMainFile and files.size() > 1) {
+    // the input files would be concatenated into one output
+    fmt::print(stderr, "-include-input with several files requires -in-place\n");
+    return 1;
+  }
+
+  unsigned jobs = Jobs == 0 ? std::thread::hardware_concurrency() : Jobs;
+  if (GenerateInline and jobs > 1) {
+    // translation units share headers that are rewritten in place
+    fmt::print(stderr, "-inline modifies shared files; processing serially\n");
+    jobs = 1;
+  }
+#if LLVM_VERSION_MAJOR < 8
+  if (jobs > 1) {
+    fmt::print(stderr, "-j requires LLVM 8 or newer; processing serially\n");
+    jobs = 1;
+  }
+#endif
 
+  FILE* out = nullptr;
   if (Filename == "") {
     out = stdout;
   } else {
     out = fopen(Filename.c_str(), "w");
+    if (out == nullptr) {
+      fmt::print(stderr, "Could not open {}\n", Filename);
+      return 1;
+    }
   }
 
-  if (IncludeVTHeader) {
+  if (IncludeVTHeader and not InPlace) {
     fmt::print(out, "#include <vt/transport.h>\n");
   }
 
-  for (auto&& e : Includes) {
-    auto str = std::string("-I") + e;
-    ArgumentsAdjuster ad1 = getInsertArgumentAdjuster(str.c_str());
-    Tool.appendArgumentsAdjuster(ad1);
-    fmt::print(stderr, "Including {}\n", e);
+  if (SharedDir != "") {
+    shared_records = std::make_unique<sanitizer::SharedRecords>(SharedDir);
+  }
+  if (CacheDir != "" and not GenerateInline) {
+    analysis_cache = std::make_unique<sanitizer::AnalysisCache>(CacheDir);
+  }
+
+  if (PCHHeader != "") {
+    prefix_header = std::make_unique<sanitizer::PrefixHeader>(PCHHeader, PCHDir);
+    preparePrefixHeader(db, files, jobs);
+  }
+
+  std::vector<TUOutput> outputs(files.size());
+  auto const start = std::chrono::steady_clock::now();
+
+  auto process = [&](std::size_t i) {
+    if (IncludeVTHeader and InPlace) {
+      fmt::format_to(outputs[i].code, "#include <vt/transport.h>\n");
+    }
+    outputs[i].prefix = outputs[i].code.size();
+    outputs[i].failed = processTranslationUnit(db, files[i], outputs[i]) != 0;
+  };
+
+  runJobs(files.size(), jobs, process);
+
+  int failures = 0;
+
+  if (shared_records != nullptr) {
+    if (auto ec = shared_records->write()) {
+      fmt::print(stderr, "Could not write shared records: {}\n", ec.message());
+      return 1;
+    }
+    fmt::print(
+      stderr, "Shared {} records across translation units, skipped {} repeats\n",
+      shared_records->numClaimed(), shared_records->numSkipped()
+    );
   }
 
-  Tool.run(newFrontendActionFactory<MyFrontendAction>().get());
+  if (analysis_cache != nullptr) {
+    fmt::print(
+      stderr, "Analysis cache: {} of {} translation units and {} of {} records reused\n",
+      analysis_cache->tuHits(),
+      analysis_cache->tuHits() + analysis_cache->tuMisses(),
+      analysis_cache->recordHits(),
+      analysis_cache->recordHits() + analysis_cache->recordMisses()
+    );
+  }
+
+  // Output in database order regardless of the order TUs finished in
+  std::unordered_set<sanitizer::HashType> written;
+  for (std::size_t i = 0; i < files.size(); i++) {
+    auto& o = outputs[i];
+    failures += o.failed ? 1 : 0;
+
+    if (statsEnabled()) {
+      sanitizer::PhaseTimer::begin(&o.stats);
+    }
+    sanitizer::PhaseTimer::enter(sanitizer::Phase::Output);
+
+    if (analysis_cache != nullptr and not o.failed and not o.cached) {
+      storeTranslationUnit(o);
+    }
+
+    std::set<std::string> shared_files;
+    for (auto&& key : o.shared) {
+      if (shared_records->hasCode(key.file) and shared_files.insert(key.file).second) {
+        fmt::format_to(o.code, "#include \"{}\"\n", shared_records->headerFor(key.file));
+      }
+    }
+
+    if (not InPlace) {
+      writeSharedOutput(out, o, written);
+    } else if (not o.failed) {
+      auto ec = sanitizer::replaceFile(files[i], StringRef{o.code.data(), o.code.size()});
+      if (ec) {
+        fmt::print(stderr, "Could not replace {}: {}\n", files[i], ec.message());
+        failures++;
+      } else {
+        fmt::print(stderr, "Replaced {}\n", files[i]);
+      }
+    }
+
+    sanitizer::PhaseTimer::leave();
+    sanitizer::PhaseTimer::end();
+    o.stats.bytes = o.code.size() - o.prefix;
+  }
+
+  auto const wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start
+  ).count();
+  if (Stats) {
+    printStats(outputs, jobs, wall_ns);
+  }
+  if (StatsJSON != "" and not writeStatsJSON(files, outputs, jobs, wall_ns)) {
+    fmt::print(stderr, "Could not write {}\n", StatsJSON);
+    failures++;
+  }
 
-  if (Filename == "" and out != nullptr) {
+  if (Filename != "") {
     fclose(out);
   }
-  return 0;
+  return failures > 0 ? 1 : 0;
 }
@@ -0,0 +1,187 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                              shared_records.cc
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#include "common.h"
+#include "shared_records.h"
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace sanitizer {
+
+/*static*/ bool RecordKey::make(
+  clang::CXXRecordDecl const* rd, RecordKey& key
+) {
+  using clang::TemplateSpecializationKind;
+
+  if (
+    rd == nullptr or
+    not rd->isThisDeclarationADefinition() or
+    rd->getTemplateSpecializationKind() != TemplateSpecializationKind::TSK_Undeclared or
+    rd->isInAnonymousNamespace() or
+    rd->getParentFunctionOrMethod() != nullptr
+  ) {
+    return false;
+  }
+
+  auto const& ctx = rd->getASTContext();
+  auto const& sm = ctx.getSourceManager();
+  auto const loc = sm.getExpansionLoc(rd->getLocation());
+  if (sm.isInMainFile(loc)) {
+    return false;
+  }
+
+  auto const entry = sm.getFileEntryForID(sm.getFileID(loc));
+  if (entry == nullptr) {
+    return false;
+  }
+
+  // relative to the working directory of the compile command
+  llvm::SmallString<256> file{entry->getName()};
+  sm.getFileManager().makeAbsolutePath(file);
+  llvm::sys::path::remove_dots(file, true);
+
+  auto const text = clang::Lexer::getSourceText(
+    clang::CharSourceRange::getTokenRange(rd->getSourceRange()), sm,
+    ctx.getLangOpts()
+  );
+
+  key.qual_name = rd->getQualifiedNameAsString();
+  key.file = file.str().str();
+  key.content_hash = hashBytes(text);
+  return true;
+}
+
+SharedRecords::SharedRecords(std::string const& in_dir) {
+  llvm::SmallString<256> dir{in_dir};
+  llvm::sys::fs::make_absolute(dir);
+  dir_ = dir.str().str();
+}
+
+bool SharedRecords::claim(RecordKey const& key) {
+  std::lock_guard<std::mutex> guard{mutex_};
+  if (claimed_.insert(key.str()).second) {
+    return true;
+  }
+  skipped_++;
+  return false;
+}
+
+void SharedRecords::emit(RecordKey const& key, std::string code) {
+  if (code.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard{mutex_};
+  files_[key.file][key.str()] = std::move(code);
+}
+
+std::string SharedRecords::codeFor(RecordKey const& key) const {
+  std::lock_guard<std::mutex> guard{mutex_};
+  auto file = files_.find(key.file);
+  if (file == files_.end()) {
+    return "";
+  }
+  auto record = file->second.find(key.str());
+  return record == file->second.end() ? "" : record->second;
+}
+
+std::string SharedRecords::headerFor(std::string const& file) const {
+  llvm::SmallString<256> path{dir_};
+  llvm::sys::path::append(
+    path,
+    fmt::format(
+      "{}.{}.sanitizer.h", llvm::sys::path::stem(file).str(),
+      hashString(hashBytes(file))
+    )
+  );
+  return path.str().str();
+}
+
+bool SharedRecords::hasCode(std::string const& file) const {
+  std::lock_guard<std::mutex> guard{mutex_};
+  return files_.find(file) != files_.end();
+}
+
+std::error_code SharedRecords::write() const {
+  std::lock_guard<std::mutex> guard{mutex_};
+
+  if (auto ec = llvm::sys::fs::create_directories(dir_)) {
+    return ec;
+  }
+
+  for (auto&& file : files_) {
+    std::error_code ec;
+    llvm::raw_fd_ostream os{headerFor(file.first), ec, llvm::sys::fs::F_None};
+    if (ec) {
+      return ec;
+    }
+
+    auto const guard_name = fmt::format(
+      "INCLUDED_SANITIZER_GENERATED_{}", hashString(hashBytes(file.first))
+    );
+    os << fmt::format("#if !defined {}\n#define {}\n\n", guard_name, guard_name);
+    os << fmt::format("// generated by the sanitizer for {}\n\n", file.first);
+    for (auto&& record : file.second) {
+      os << record.second;
+    }
+    os << fmt::format("\n#endif /*{}*/\n", guard_name);
+  }
+  return std::error_code{};
+}
+
+std::size_t SharedRecords::numClaimed() const {
+  std::lock_guard<std::mutex> guard{mutex_};
+  return claimed_.size();
+}
+
+std::size_t SharedRecords::numSkipped() const {
+  std::lock_guard<std::mutex> guard{mutex_};
+  return skipped_;
+}
+
+} /* end namespace sanitizer */
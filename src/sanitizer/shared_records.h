@@ -0,0 +1,169 @@
+/*
+//@HEADER
+// *****************************************************************************
+//
+//                               shared_records.h
+//                           DARMA Toolkit v. 1.0.0
+//                       DARMA/Serialization Sanitizer
+//
+// Copyright 2019 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from this
+//   software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// *****************************************************************************
+//@HEADER
+*/
+
+#if !defined INCLUDED_SANITIZER_SHARED_RECORDS_H
+#define INCLUDED_SANITIZER_SHARED_RECORDS_H
+
+#include "common.h"
+#include "hash.h"
+
+#include "clang/AST/DeclCXX.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+
+namespace sanitizer {
+
+/**
+ * \struct RecordKey
+ *
+ * \brief Stable identity of a record across translation units: its qualified
+ * name, the file that defines it and a hash of its source text
+ */
+struct RecordKey {
+
+  /**
+   * \brief Compute the key of a record that can be shared across translation
+   * units. Only non-template records defined outside the main file (and not
+   * local to a function or an anonymous namespace) are shared; everything else
+   * is generated per translation unit.
+   *
+   * \param[in] rd the record
+   * \param[out] key the key
+   *
+   * \return whether the record can be shared
+   */
+  static bool make(clang::CXXRecordDecl const* rd, RecordKey& key);
+
+  std::string str() const {
+    return qual_name + "|" + file + "|" + hashString(content_hash);
+  }
+
+  std::string qual_name;
+  std::string file;
+  HashType content_hash = 0;
+};
+
+/**
+ * \struct SharedRecords
+ *
+ * \brief Process-wide registry of records shared across translation units.
+ * The first translation unit that sees a record claims it and generates its
+ * code; the others skip the record entirely. The generated code is written to
+ * one header per defining file, which every translation unit that sees the
+ * record includes. Safe to use from concurrent translation units.
+ */
+struct SharedRecords {
+
+  explicit SharedRecords(std::string const& in_dir);
+
+  /**
+   * \brief Claim a record for generation
+   *
+   * \param[in] key the record key
+   *
+   * \return whether the caller must generate the record
+   */
+  bool claim(RecordKey const& key);
+
+  /**
+   * \brief Store the code generated for a claimed record
+   *
+   * \param[in] key the record key
+   * \param[in] code the generated code
+   */
+  void emit(RecordKey const& key, std::string code);
+
+  /**
+   * \brief Get the code generated for a record
+   *
+   * \param[in] key the record key
+   *
+   * \return the code, empty if none was generated
+   */
+  std::string codeFor(RecordKey const& key) const;
+
+  /**
+   * \brief Get the generated header for a defining file
+   *
+   * \param[in] file the defining file
+   *
+   * \return the absolute path of the generated header
+   */
+  std::string headerFor(std::string const& file) const;
+
+  /**
+   * \brief Whether any code was generated for a defining file
+   *
+   * \param[in] file the defining file
+   */
+  bool hasCode(std::string const& file) const;
+
+  /**
+   * \brief Write the generated headers that have code
+   *
+   * \return the error, if any
+   */
+  std::error_code write() const;
+
+  std::size_t numClaimed() const;
+  std::size_t numSkipped() const;
+
+private:
+  std::string dir_;
+  mutable std::mutex mutex_;
+  /// Generated code by defining file, then by record key
+  std::map<std::string, std::map<std::string, std::string>> files_;
+  /// Keys of all claimed records
+  std::set<std::string> claimed_;
+  /// Number of times a record was seen after being claimed
+  std::size_t skipped_ = 0;
+};
+
+} /* end namespace sanitizer */
+
+#endif /*INCLUDED_SANITIZER_SHARED_RECORDS_H*/
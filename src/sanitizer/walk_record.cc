@@ -44,6 +44,7 @@
 
 #include "common.h"
 #include "walk_record.h"
+#include "phase_timer.h"
 #include "member_list.h"
 
 #include <fmt/format.h>
@@ -65,9 +66,11 @@ void WalkRecord::walk(MatchResult const& result) {
     bool temp_instantiation = rd->getTemplateInstantiationPattern() != nullptr;
     if (gen_inline_ && temp_instantiation) {
       // skip template instantiation when generating inline
+      countSkipped(SkipReason::Instantiation);
       return;
     } else if (rd->getDescribedClassTemplate()) {
       // skip template classes when generating out-of-line
+      countSkipped(SkipReason::TemplatePattern);
       return;
     }
 
@@ -77,12 +80,14 @@ void WalkRecord::walk(MatchResult const& result) {
       if (clang::isa<CXXRecordDecl>(p)) {
         auto parent = clang::cast<CXXRecordDecl>(p);
         if (parent->getDescribedClassTemplate()) {
+          countSkipped(SkipReason::TemplatePattern);
           return;
         }
       }
     }
 
     // Walk declarations for this struct
+    bool constrained = false;
     for (auto&& m : rd->decls()) {
       // Skip non-templated functions
       if (not m->isTemplateDecl()) {
@@ -118,6 +123,7 @@ void WalkRecord::walk(MatchResult const& result) {
           }
         #endif
 
+        constrained = true;
         continue;
       }
 
@@ -133,10 +139,17 @@ void WalkRecord::walk(MatchResult const& result) {
       // Invoke the code generator
       if (gen_ != nullptr) {
         gen_->run(rd, fn, members_);
+        countGenerated(members_.size());
       }
 
       break;
     }
+
+    if (not found_serialize_) {
+      countSkipped(
+        constrained ? SkipReason::EnableIf : SkipReason::NoSerialize
+      );
+    }
   }
 }
 
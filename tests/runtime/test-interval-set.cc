@@ -0,0 +1,135 @@
+
+#include "test-runtime-common.h"
+
+#include "interval_set.h"
+
+#include <random>
+#include <vector>
+
+using checkpoint::sanitizer::Interval;
+using checkpoint::sanitizer::IntervalSet;
+
+static std::string const name = "test-interval-set";
+
+static bool equals(IntervalSet const& set, std::vector<Interval> const& expected) {
+  auto const& got = set.getIntervals();
+  if (got.size() != expected.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < got.size(); i++) {
+    if (got[i].begin != expected[i].begin or got[i].end != expected[i].end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void testMerge() {
+  IntervalSet set;
+  EXPECT(name, set.empty());
+  set.insert(10, 10);
+  EXPECT(name, set.empty());
+
+  set.insert(10, 20);
+  set.insert(20, 30);  // abuts: extends the last interval
+  set.insert(40, 50);  // appends
+  set.insert(45, 60);  // overlaps the last
+  EXPECT(name, equals(set, {{10, 30}, {40, 60}}));
+
+  set.insert(0, 5);    // before everything
+  set.insert(32, 35);  // in a gap
+  EXPECT(name, equals(set, {{0, 5}, {10, 30}, {32, 35}, {40, 60}}));
+
+  set.insert(5, 10);   // abuts on both sides
+  EXPECT(name, equals(set, {{0, 30}, {32, 35}, {40, 60}}));
+
+  set.insert(25, 45);  // spans several
+  EXPECT(name, equals(set, {{0, 60}}));
+
+  EXPECT(name, set.contains(0));
+  EXPECT(name, set.contains(59));
+  EXPECT(name, not set.contains(60));
+
+  set.clear();
+  EXPECT(name, set.empty());
+  EXPECT(name, not set.contains(0));
+}
+
+static void testSweep() {
+  IntervalSet set;
+  set.insert(4, 8);
+  set.insert(12, 20);
+
+  // ranges [0,4) [4,6) [6,14) [14,16) [20,24)
+  std::vector<Interval> const ranges = {{0, 4}, {4, 6}, {6, 14}, {14, 16}, {20, 24}};
+  std::vector<std::size_t> const expected = {0, 2, 4, 2, 0};
+  std::vector<std::size_t> got;
+  set.sweep(
+    ranges.size(), [&](std::size_t i) { return ranges[i]; },
+    [&](std::size_t i, std::size_t bytes) {
+      EXPECT(name, i == got.size());
+      got.push_back(bytes);
+    }
+  );
+  EXPECT(name, got == expected);
+}
+
+// Random insertions checked against a byte map
+static void testRandom() {
+  std::mt19937 rng{42};
+  std::size_t const universe = 256;
+
+  for (int round = 0; round < 200; round++) {
+    IntervalSet set;
+    std::vector<bool> bytes(universe, false);
+    std::uniform_int_distribution<std::size_t> pos{0, universe - 1};
+    std::uniform_int_distribution<std::size_t> len{0, 16};
+
+    for (int n = 0; n < 20; n++) {
+      auto const begin = pos(rng);
+      auto const end = std::min(universe, begin + len(rng));
+      set.insert(begin, end);
+      for (auto b = begin; b < end; b++) {
+        bytes[b] = true;
+      }
+    }
+
+    // disjoint, sorted, and neither empty nor adjacent
+    auto const& intervals = set.getIntervals();
+    for (std::size_t i = 0; i < intervals.size(); i++) {
+      EXPECT(name, intervals[i].begin < intervals[i].end);
+      if (i > 0) {
+        EXPECT(name, intervals[i - 1].end < intervals[i].begin);
+      }
+    }
+
+    for (std::size_t b = 0; b < universe; b++) {
+      EXPECT(name, set.contains(b) == bytes[b]);
+    }
+
+    // consecutive ranges of random lengths cover the universe
+    std::vector<Interval> ranges;
+    for (std::size_t b = 0; b < universe; ) {
+      auto const e = std::min(universe, b + 1 + len(rng));
+      ranges.push_back(Interval{b, e});
+      b = e;
+    }
+    set.sweep(
+      ranges.size(), [&](std::size_t i) { return ranges[i]; },
+      [&](std::size_t i, std::size_t covered) {
+        std::size_t expected = 0;
+        for (auto b = ranges[i].begin; b < ranges[i].end; b++) {
+          expected += bytes[b] ? 1 : 0;
+        }
+        EXPECT(name, covered == expected);
+      }
+    );
+  }
+}
+
+int main() {
+  testMerge();
+  testSweep();
+  testRandom();
+  return testResult(name);
+}
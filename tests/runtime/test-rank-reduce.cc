@@ -0,0 +1,162 @@
+
+#include "test-runtime-common.h"
+
+#include "rank_reduce.h"
+#include "report.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using checkpoint::sanitizer::RankTransport;
+using checkpoint::sanitizer::Report;
+using checkpoint::sanitizer::reduceReport;
+using checkpoint::sanitizer::report_root_node;
+
+static std::string const name = "test-rank-reduce";
+static int const num_ranks = 6;
+
+// Buffered mailboxes between fake ranks: a send never blocks, so the ranks
+// can run one after the other, children (higher ranks) first
+struct Mailboxes {
+  std::map<std::pair<int, int>, std::vector<std::string>> boxes;
+};
+
+struct StubTransport : RankTransport {
+  StubTransport(Mailboxes& in_mail, int in_rank)
+    : mail_(in_mail),
+      rank_(in_rank)
+  { }
+
+  int rank() const override { return rank_; }
+  int size() const override { return num_ranks; }
+
+  bool send(int dest, std::string const& buf) override {
+    mail_.boxes[std::make_pair(rank_, dest)].push_back(buf);
+    return true;
+  }
+
+  bool recv(int src, std::string& buf) override {
+    auto& box = mail_.boxes[std::make_pair(src, rank_)];
+    if (box.empty()) {
+      return false;
+    }
+    buf = box.front();
+    box.erase(box.begin());
+    return true;
+  }
+
+private:
+  Mailboxes& mail_;
+  int rank_ = 0;
+};
+
+// Even ranks miss Foo::a 2^rank times; rank 5 partially serializes Bar::b
+static Report makeReport(int rank) {
+  Report report;
+  report.pids.push_back(static_cast<uint32_t>(1000 + rank));
+  report.frames_pushed = 10;
+  report.frames_reused = 5;
+  auto const foo = report.addNode(report_root_node, report.addString("Foo"));
+  auto const bar = report.addNode(foo, report.addString("Bar"));
+  auto const i = report.addString("int");
+  if (rank % 2 == 0) {
+    report.add(report.addString("a"), i, false, foo, uint64_t{1} << rank);
+  }
+  if (rank == 5) {
+    report.add(report.addString("b"), i, true, bar, 7, 14, 28);
+  }
+  report.setRank(static_cast<uint32_t>(rank));
+  return report;
+}
+
+static Report::Entry const* findEntry(Report const& report, std::string const& member) {
+  for (auto&& e : report.entries) {
+    if (report.strings[e.name] == member) {
+      return &e;
+    }
+  }
+  return nullptr;
+}
+
+static void checkMerged(Report const& report) {
+  EXPECT(name, report.pids.size() == num_ranks);
+  EXPECT(name, report.frames_pushed == 10 * num_ranks);
+  EXPECT(name, report.frames_reused == 5 * num_ranks);
+  EXPECT(name, report.entries.size() == 2);
+
+  auto a = findEntry(report, "a");
+  EXPECT(name, a != nullptr);
+  if (a != nullptr) {
+    EXPECT(name, not a->partial);
+    EXPECT(name, a->instances == 1 + 4 + 16);
+    EXPECT(name, a->ranks == 3);
+    EXPECT(name, a->first_rank == 0);
+    EXPECT(name, a->histogram[0] == 1);
+    EXPECT(name, a->histogram[2] == 1);
+    EXPECT(name, a->histogram[4] == 1);
+    EXPECT(name, a->histogram[1] == 0 and a->histogram[3] == 0);
+    EXPECT(name, a->stacks.size() == 1);
+  }
+
+  auto b = findEntry(report, "b");
+  EXPECT(name, b != nullptr);
+  if (b != nullptr) {
+    EXPECT(name, b->partial);
+    EXPECT(name, b->instances == 7);
+    EXPECT(name, b->bytes == 14 and b->total == 28);
+    EXPECT(name, b->ranks == 1);
+    EXPECT(name, b->first_rank == 5);
+    EXPECT(name, b->histogram[2] == 1);
+    EXPECT(name, b->stacks.size() == 1);
+    if (b->stacks.size() == 1) {
+      // Bar nested in Foo: the node of Bar has Foo as parent
+      auto const& node = report.nodes[b->stacks[0].node];
+      EXPECT(name, report.strings[node.tinfo] == "Bar");
+      EXPECT(name, node.parent != report_root_node);
+      if (node.parent != report_root_node) {
+        auto const& parent = report.nodes[node.parent];
+        EXPECT(name, report.strings[parent.tinfo] == "Foo");
+        EXPECT(name, parent.parent == report_root_node);
+      }
+    }
+  }
+}
+
+int main() {
+  Mailboxes mail;
+  Report root;
+  for (int rank = num_ranks - 1; rank >= 0; rank--) {
+    StubTransport transport{mail, rank};
+    auto report = makeReport(rank);
+    auto const is_root = reduceReport(report, transport);
+    EXPECT(name, is_root == (rank == 0));
+    if (is_root) {
+      root = std::move(report);
+    }
+  }
+  for (auto&& box : mail.boxes) {
+    EXPECT(name, box.second.empty());
+  }
+  checkMerged(root);
+
+  // serialize -> deserialize keeps every field
+  std::string buf, error;
+  root.serialize(buf);
+  Report copy;
+  EXPECT(name, copy.deserialize(buf, error));
+  EXPECT(name, error.empty());
+  checkMerged(copy);
+  EXPECT(name, copy.strings == root.strings);
+  EXPECT(name, copy.nodes.size() == root.nodes.size());
+
+  std::string again;
+  copy.serialize(again);
+  EXPECT(name, again == buf);
+
+  // a truncated buffer is rejected rather than read partially
+  Report truncated;
+  EXPECT(name, not truncated.deserialize(buf.substr(0, buf.size() / 2), error));
+
+  return testResult(name);
+}
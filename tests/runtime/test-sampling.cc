@@ -0,0 +1,55 @@
+#include "test-runtime-common.h"
+
+#include "sanitize_rt.h"
+
+#include <cstdlib>
+#include <thread>
+
+using checkpoint::sanitizer::Sanitizer;
+using checkpoint::sanitizer::StaticName;
+
+static std::string const name = "test-sampling";
+
+struct TestSanitizer : Sanitizer {
+  using Sanitizer::totals;
+};
+
+// An Outer object holding one Inner object
+static void serialize(Sanitizer& s) {
+  s.push(StaticName{"Outer"});
+  s.push(StaticName{"Inner"});
+  s.pop(StaticName{"Inner"});
+  s.pop(StaticName{"Outer"});
+}
+
+// Every other object is checked, and the objects nested in one that is
+// sampled out are never counted for their own type
+static void testNested() {
+  TestSanitizer s;
+  for (int i = 0; i < 4; i++) {
+    serialize(s);
+  }
+  // Outer checked at 0 and 2; Inner seen twice and checked at 0
+  EXPECT(name, s.totals().frames_pushed == 3);
+  EXPECT(name, s.totals().frames_skipped == 3);
+}
+
+// Each thread counts the objects of a type it pushes on its own
+static void testPerThread() {
+  TestSanitizer s;
+  for (int t = 0; t < 2; t++) {
+    std::thread{[&] {
+      s.push(StaticName{"Inner"});
+      s.pop(StaticName{"Inner"});
+    }}.join();
+  }
+  EXPECT(name, s.totals().frames_pushed == 2);
+  EXPECT(name, s.totals().frames_skipped == 0);
+}
+
+int main() {
+  setenv("VT_SANITIZE_SAMPLE_EVERY", "2", 1);
+  testNested();
+  testPerThread();
+  return testResult(name);
+}
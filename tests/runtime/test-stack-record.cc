@@ -0,0 +1,220 @@
+
+#include "test-runtime-common.h"
+
+#include "stack_record.h"
+
+#include <cstddef>
+#include <vector>
+
+using checkpoint::sanitizer::MemberLayout;
+using checkpoint::sanitizer::StackRecord;
+using checkpoint::sanitizer::StaticName;
+
+static std::string const name = "test-stack-record";
+
+// A layout of n int members at ascending offsets
+static std::vector<MemberLayout> intLayout(std::size_t n) {
+  std::vector<MemberLayout> layout;
+  for (std::size_t i = 0; i < n; i++) {
+    layout.push_back(MemberLayout{
+      i * sizeof(int), sizeof(int), sizeof(int), StaticName{"m"},
+      StaticName{"int"}
+    });
+  }
+  return layout;
+}
+
+// Offsets of the members reported missing
+static std::vector<std::size_t> missingOffsets(StackRecord const& frame) {
+  std::vector<std::size_t> missing;
+  frame.validateLayout(
+    [&](MemberLayout const& m) { missing.push_back(m.offset); },
+    [&](MemberLayout const&, std::size_t) {
+      EXPECT(name, false && "unexpected partial member");
+    }
+  );
+  return missing;
+}
+
+// Members tracked in the bitset across several words: every member not
+// serialized or ignored is missing, in table order
+static void testBitset() {
+  std::size_t const n = 130;
+  auto const layout = intLayout(n);
+  std::vector<int> object(n);
+
+  StackRecord frame{1};
+  EXPECT(name, frame.setLayout(object.data(), layout.data(), n));
+  EXPECT(name, frame.hasLayout());
+  for (std::size_t i = 0; i < n; i++) {
+    if (i % 3 == 0) {
+      frame.isSerialized(&object[i], 0, 2);
+    } else if (i % 3 == 1) {
+      frame.ignoreElm(&object[i], 3, 2);
+    }
+  }
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 2; i < n; i += 3) {
+    expected.push_back(i * sizeof(int));
+  }
+  EXPECT(name, missingOffsets(frame) == expected);
+
+  // all covered: the word-wise fast path finds nothing
+  for (std::size_t i = 2; i < n; i += 3) {
+    frame.isSerialized(&object[i], 0, 2);
+  }
+  EXPECT(name, missingOffsets(frame).empty());
+  EXPECT(name, frame.getEntries().empty());
+}
+
+// Hooks invoked before the layout is set are carried over into the bitset
+static void testCarryOver() {
+  auto const layout = intLayout(4);
+  int object[4] = {};
+
+  StackRecord frame{1};
+  frame.isSerialized(&object[1], 0, 2);
+  frame.ignoreElm(&object[3], 3, 2);
+  EXPECT(name, frame.setLayout(object, layout.data(), layout.size()));
+  std::vector<std::size_t> const expected = {0, 2 * sizeof(int)};
+  EXPECT(name, missingOffsets(frame) == expected);
+}
+
+// A second table or a table with descending offsets is not taken
+static void testRejected() {
+  auto const layout = intLayout(3);
+  int object[3] = {};
+
+  StackRecord frame{1};
+  EXPECT(name, frame.setLayout(object, layout.data(), layout.size()));
+  EXPECT(name, not frame.setLayout(object, layout.data(), layout.size()));
+
+  auto descending = layout;
+  std::swap(descending[0], descending[2]);
+  StackRecord other{1};
+  EXPECT(name, not other.setLayout(object, descending.data(), descending.size()));
+  EXPECT(name, not other.hasLayout());
+
+  // reset drops the layout so a pooled frame can take another one
+  frame.reset(2);
+  EXPECT(name, not frame.hasLayout());
+  EXPECT(name, frame.setLayout(object, layout.data(), layout.size()));
+}
+
+// Empty members share their offset with the next member: serializing that
+// address covers all of them
+static void testSharedOffset() {
+  StaticName const n{"m"}, t{"t"};
+  MemberLayout const layout[] = {
+    {0, 1, 0, n, t},
+    {0, sizeof(int), sizeof(int), n, t},
+    {sizeof(int), sizeof(int), sizeof(int), n, t},
+  };
+  int object[2] = {};
+
+  StackRecord frame{1};
+  EXPECT(name, frame.setLayout(object, layout, 3));
+  frame.isSerialized(&object[0], 0, 2);
+  std::vector<std::size_t> const expected = {sizeof(int)};
+  EXPECT(name, missingOffsets(frame) == expected);
+
+  // an ignored address covers them too, including when carried over
+  StackRecord other{1};
+  other.ignoreElm(&object[0], 3, 2);
+  EXPECT(name, other.setLayout(object, layout, 3));
+  EXPECT(name, missingOffsets(other) == expected);
+}
+
+struct Inner {
+  char c;
+  double d;
+};
+
+struct Outer {
+  int a;
+  Inner in;
+  int b;
+};
+
+// Members are checked against the byte ranges serialized in bulk: one with
+// none of its bytes covered is missing, one with fewer than its data size
+// (which excludes padding) is partial, and padding is not required
+static void testCoverage() {
+  StaticName const n{"m"}, t{"t"};
+  MemberLayout const layout[] = {
+    {offsetof(Outer, a), sizeof(int), sizeof(int), n, t},
+    {offsetof(Outer, in), sizeof(Inner), sizeof(char) + sizeof(double), n, t},
+    {offsetof(Outer, b), sizeof(int), sizeof(int), n, t},
+  };
+  auto validate = [&](StackRecord const& frame, std::vector<std::size_t>& missing,
+                      std::vector<std::size_t>& partial) {
+    return frame.validateLayout(
+      [&](MemberLayout const& m) { missing.push_back(m.offset); },
+      [&](MemberLayout const& m, std::size_t bytes) {
+        partial.push_back(m.offset);
+        EXPECT(name, m.offset == offsetof(Outer, in));
+        EXPECT(name, bytes == sizeof(char));
+      }
+    );
+  };
+
+  {
+    // only the first field of in, and b through a bulk range
+    Outer o;
+    StackRecord frame{1};
+    EXPECT(name, frame.setLayout(&o, layout, 3));
+    frame.isSerialized(&o.in.c, sizeof(char), 2);
+    frame.isSerialized(&o.b, sizeof(int), 2);
+    std::vector<std::size_t> missing, partial;
+    EXPECT(name, validate(frame, missing, partial) == 2);
+    EXPECT(name, missing == std::vector<std::size_t>{offsetof(Outer, a)});
+    EXPECT(name, partial == std::vector<std::size_t>{offsetof(Outer, in)});
+    EXPECT(name, frame.inSerializedRange(&o.b));
+    EXPECT(name, not frame.inSerializedRange(&o.a));
+  }
+
+  {
+    // both fields of in without its padding count as fully serialized
+    Outer o;
+    StackRecord frame{1};
+    EXPECT(name, frame.setLayout(&o, layout, 3));
+    frame.isSerialized(&o.a, sizeof(int), 2);
+    frame.isSerialized(&o.in.c, sizeof(char), 2);
+    frame.isSerialized(&o.in.d, sizeof(double), 2);
+    frame.isSerialized(&o.b, sizeof(int), 2);
+    std::vector<std::size_t> missing, partial;
+    EXPECT(name, validate(frame, missing, partial) == 0);
+  }
+
+  {
+    // one bulk range over the whole object
+    Outer o;
+    StackRecord frame{1};
+    EXPECT(name, frame.setLayout(&o, layout, 3));
+    frame.isSerialized(&o, sizeof(Outer), 2);
+    std::vector<std::size_t> missing, partial;
+    EXPECT(name, validate(frame, missing, partial) == 0);
+  }
+
+  {
+    // with bulk ranges, an ignored member none of whose bytes are covered is
+    // not missing
+    Outer o;
+    StackRecord frame{1};
+    EXPECT(name, frame.setLayout(&o, layout, 3));
+    frame.isSerialized(&o.a, sizeof(int), 2);
+    frame.ignoreElm(&o.in, 3, 2);
+    frame.isSerialized(&o.b, sizeof(int), 2);
+    std::vector<std::size_t> missing, partial;
+    EXPECT(name, validate(frame, missing, partial) == 0);
+  }
+}
+
+int main() {
+  testBitset();
+  testCarryOver();
+  testRejected();
+  testSharedOffset();
+  testCoverage();
+  return testResult(name);
+}
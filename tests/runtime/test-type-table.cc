@@ -0,0 +1,63 @@
+#include "test-runtime-common.h"
+
+#include "type_table.h"
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+using checkpoint::sanitizer::NameIDType;
+using checkpoint::sanitizer::TypeState;
+using checkpoint::sanitizer::TypeTable;
+
+static std::string const name = "test-type-table";
+
+// Every type ID has a state, including IDs far past the first chunks
+static void testRange() {
+  TypeTable table;
+  std::vector<NameIDType> const ids = {
+    0, 1, 1023, 1024, (1u << 20) - 1, 1u << 20, 1u << 22,
+    std::numeric_limits<NameIDType>::max()
+  };
+  for (auto id : ids) {
+    table.get(id).checked.store(id, std::memory_order_relaxed);
+  }
+  for (auto id : ids) {
+    EXPECT(name, table.get(id).checked.load() == id);
+  }
+  EXPECT(name, &table.get(1u << 22) == &table.get(1u << 22));
+
+  // forEach visits the states allocated with their IDs
+  std::size_t found = 0;
+  table.forEach([&](NameIDType id, TypeState const& state) {
+    if (state.checked.load() == id and id != 0) {
+      found++;
+    }
+  });
+  EXPECT(name, found == ids.size() - 1);
+}
+
+// Threads racing for the same unallocated chunk see the same state
+static void testConcurrent() {
+  TypeTable table;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&] {
+      for (NameIDType id = 5u << 24; id < (5u << 24) + 4096; id++) {
+        table.get(id).checked.fetch_add(1);
+      }
+    });
+  }
+  for (auto&& t : threads) {
+    t.join();
+  }
+  for (NameIDType id = 5u << 24; id < (5u << 24) + 4096; id++) {
+    EXPECT(name, table.get(id).checked.load() == 8);
+  }
+}
+
+int main() {
+  testRange();
+  testConcurrent();
+  return testResult(name);
+}
@@ -0,0 +1,105 @@
+#include "test-runtime-common.h"
+
+#include "sanitize_rt.h"
+
+#include <cstdlib>
+
+using checkpoint::sanitizer::MemberLayout;
+using checkpoint::sanitizer::Report;
+using checkpoint::sanitizer::Sanitizer;
+using checkpoint::sanitizer::StaticName;
+
+static std::string const name = "test-validation-cache";
+
+struct TestSanitizer : Sanitizer {
+  using Sanitizer::buildReport;
+  using Sanitizer::totals;
+};
+
+struct Holder {
+  int a[4];
+};
+
+static MemberLayout const layout[] = {
+  {0, sizeof(int[4]), sizeof(int[4]), StaticName{"Holder::a"}, StaticName{"int [4]"}}
+};
+
+// Serialize the first n elements of a in bulk
+static void serialize(Sanitizer& s, Holder& h, std::size_t n) {
+  s.push(StaticName{"Holder"});
+  s.checkLayout(&h, layout, 1);
+  s.isSerialized(h.a, n, sizeof(int), StaticName{"int"});
+  s.pop(StaticName{"Holder"});
+}
+
+static std::size_t partialInstances(TestSanitizer& s) {
+  Report report;
+  s.buildReport(report);
+  std::size_t instances = 0;
+  for (auto&& e : report.entries) {
+    if (e.partial) {
+      instances += e.instances;
+    }
+  }
+  return instances;
+}
+
+// A proven type whose bulk range later covers fewer elements is escalated,
+// so the partially serialized member is still found
+static void testShrunkBulkRange() {
+  TestSanitizer s;
+  Holder h = {};
+  for (int i = 0; i < 4; i++) {
+    serialize(s, h, 4);
+  }
+  EXPECT(name, partialInstances(s) == 0);
+
+  serialize(s, h, 2);
+  EXPECT(name, partialInstances(s) == 1);
+}
+
+struct Pair {
+  int a;
+  int b;
+};
+
+// Serialize both members, or a alone with b skipped
+static void serialize(Sanitizer& s, Pair& p, bool both) {
+  s.push(StaticName{"Pair"});
+  s.checkMember(&p.a, StaticName{"Pair::a"}, StaticName{"int"});
+  s.checkMember(&p.b, StaticName{"Pair::b"}, StaticName{"int"});
+  s.isSerialized(&p.a, 1, StaticName{"int"});
+  if (both) {
+    s.isSerialized(&p.b, 1, StaticName{"int"});
+  } else {
+    s.skipMember(&p.b, StaticName{"Pair::b"}, StaticName{"int"});
+  }
+  s.pop(StaticName{"Pair"});
+}
+
+// A clean object that escalates its type starts proving its own layout, so
+// a type with a second legitimate layout is proven again after it
+static void testSecondLayout() {
+  TestSanitizer s;
+  Pair p = {};
+  // proven after two objects, the next two only fingerprinted
+  for (int i = 0; i < 4; i++) {
+    serialize(s, p, true);
+  }
+  EXPECT(name, s.totals().frames_fingerprinted == 2);
+
+  // the first escalates and counts toward proving the new layout, so only
+  // the second is checked in full before the type is proven again
+  for (int i = 0; i < 4; i++) {
+    serialize(s, p, false);
+  }
+  EXPECT(name, s.totals().frames_fingerprinted == 5);
+  EXPECT(name, partialInstances(s) == 0);
+}
+
+int main() {
+  setenv("VT_SANITIZE_CACHE_AFTER", "2", 1);
+  testShrunkBulkRange();
+  testSecondLayout();
+  return testResult(name);
+}
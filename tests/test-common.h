@@ -45,20 +45,42 @@
 #if !defined INCLUDED_SANITIZER_TEST_COMMON_H
 #define INCLUDED_SANITIZER_TEST_COMMON_H
 
+#include "runtime_interface.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
+#include <utility>
 
 namespace checkpoint { namespace serializers {
 
 std::vector<void*> addr;
 std::vector<void*> checked;
 
+/// Byte ranges serialized, kept across \c testClass for coverage checks
+std::vector<std::pair<uintptr_t, uintptr_t>> serialized;
+
+/// Entries of the layout tables checked (with \c -layout), with the address
+/// of the object, kept across \c testClass
+std::vector<std::pair<void*, ::checkpoint::sanitizer::MemberLayout>> layouts;
+
 struct Sanitizer {
   template <typename Arg, typename... Args>
   void check(Arg& m, Args&&...) {
     checked.push_back(reinterpret_cast<void*>(&m));
   }
+
+  template <std::size_t N>
+  void checkLayout(
+    void* base, ::checkpoint::sanitizer::MemberLayout const (&layout)[N]
+  ) {
+    for (auto&& m : layout) {
+      checked.push_back(static_cast<char*>(base) + m.offset);
+      layouts.emplace_back(base, m);
+    }
+  }
 };
 
 struct Serializer { };
@@ -66,6 +88,28 @@ struct Serializer { };
 template <typename SerializerT, typename T>
 void operator|(SerializerT& s, T& t) {
   addr.push_back(reinterpret_cast<void*>(&t));
+  auto const begin = reinterpret_cast<uintptr_t>(&t);
+  serialized.emplace_back(begin, begin + sizeof(T));
+}
+
+/**
+ * \brief The number of bytes of a range that were serialized
+ *
+ * \param[in] addr the start of the range
+ * \param[in] size the size of the range
+ *
+ * \return the bytes covered by the serialized ranges (assumed disjoint)
+ */
+inline std::size_t coveredBytes(void* addr, std::size_t size) {
+  auto const begin = reinterpret_cast<uintptr_t>(addr);
+  auto const end = begin + size;
+  std::size_t bytes = 0;
+  for (auto&& r : serialized) {
+    auto const lo = std::max(begin, r.first);
+    auto const hi = std::min(end, r.second);
+    bytes += hi > lo ? hi - lo : 0;
+  }
+  return bytes;
 }
 
 }} /* end namespace checkpoint::serializers */
@@ -0,0 +1,84 @@
+
+#include "test-common.h"
+
+#include <cstdio>
+#include <cstring>
+#include <typeinfo>
+
+// padding between c and d: 9 bytes of data in 16
+struct Padded {
+  char c = 0;
+  double d = 0.;
+};
+
+struct LayoutBase {
+  int base_x = 0;
+};
+
+struct MyLayout : LayoutBase {
+
+  template <typename SerializerT>
+  void serialize(SerializerT& s) {
+    s | a;
+    s | p.c;
+    s | b;
+  }
+
+  char a = 0;
+  Padded p;
+  int b = 0;
+};
+
+int main() {
+  using checkpoint::serializers::coveredBytes;
+  using checkpoint::serializers::layouts;
+
+  if (testClass<MyLayout>("test-layout") != 0) {
+    return 1;
+  }
+
+#if SANITIZER_TEST_LAYOUT
+  // one table entry per member, at offsets past the base, with the data size
+  // of the member excluding its padding; only the first byte of p was
+  // serialized, so it is partially covered; type names are typeid names
+  int success = 1;
+  if (layouts.size() != 3) {
+    fprintf(stderr, "Failure test-layout: %zu layout entries\n", layouts.size());
+    return 1;
+  }
+  for (auto&& e : layouts) {
+    auto const& m = e.second;
+    auto const member = static_cast<char*>(e.first) + m.offset;
+    if (m.offset < sizeof(LayoutBase) or m.data_size > m.size) {
+      fprintf(stderr, "Failure test-layout: bad entry %s\n", m.name.str);
+      success = 0;
+    }
+    auto const covered = coveredBytes(member, m.size);
+    bool const is_p = m.size == sizeof(Padded);
+    auto const tinfo = is_p ? typeid(Padded).name() :
+      m.size == sizeof(int) ? typeid(int).name() : typeid(char).name();
+    if (std::strcmp(m.tinfo.str, tinfo) != 0) {
+      fprintf(stderr, "Failure test-layout: %s type %s\n", m.name.str, m.tinfo.str);
+      success = 0;
+    }
+    if (is_p) {
+      if (m.data_size != sizeof(char) + sizeof(double) or covered != 1) {
+        fprintf(
+          stderr, "Failure test-layout: p: data size %zu, covered %zu\n",
+          m.data_size, covered
+        );
+        success = 0;
+      }
+    } else if (covered != m.data_size) {
+      fprintf(stderr, "Failure test-layout: %s not fully covered\n", m.name.str);
+      success = 0;
+    }
+  }
+  if (not success) {
+    return 1;
+  }
+  printf("Success test-layout: layout table and coverage match\n");
+#endif
+
+  return 0;
+}